@@ -0,0 +1,136 @@
+/**
+ * BITBOARD_BENCH
+ * Measure the time needed to compute the distance of every block
+ * from the goal with the bitboard wavefront and with a scalar
+ * breadth-first search, on a maze and on an open room.
+ *
+ * Compile: make bench
+ * Usage: ./bitboard_bench [size]
+ */
+
+#include "../lib/maze.h"
+#include "../lib/bitboard.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define DEFAULT_SIZE        4001
+#define SEED                1
+
+/**
+ * Return the current time in seconds
+ * [OUT] double: monotonic time
+ **/
+double now(void) {
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+/**
+ * Compute the distance of each block from the goal with a queue of blocks
+ * [IN] struct maze*: the maze
+ * [IN] uint32_t: goal position (x, y)
+ * [IN] uint32_t*: distances will be left here
+ * [IN] uint32_t*: queue of width * height blocks
+ * [OUT] void
+ **/
+void scalar_bfs(struct maze* m, uint32_t x, uint32_t y, uint32_t* dist, uint32_t* queue) {
+    size_t      cells = (size_t)m->width * m->height;
+    size_t      head = 0, tail = 0;
+    uint32_t    i, n, c;
+    int         dir;
+
+    for (i = 0; i < cells; i++)
+        dist[i] = DIST_NONE;
+
+    queue[tail++] = x * m->width + y;
+    dist[x * m->width + y] = 0;
+
+    while (head < tail) {
+        i = queue[head++];
+        c = i % m->width;
+        for (dir = 0; dir < 4; dir++) {
+            if ((dir == 0 && i + m->width >= cells) || (dir == 1 && c + 1 == m->width) ||
+                (dir == 2 && i < m->width) || (dir == 3 && c == 0))
+                continue;
+            n = dir == 0 ? i + m->width : dir == 1 ? i + 1 : dir == 2 ? i - m->width : i - 1;
+            if ((m->cells[n] & CELL_WALL) || dist[n] != DIST_NONE)
+                continue;
+            dist[n] = dist[i] + 1;
+            queue[tail++] = n;
+        }
+    }
+}
+
+/**
+ * Compare the two searches on a maze from its center
+ * [IN] struct maze*: the maze
+ * [IN] char*: name of the maze
+ * [OUT] void
+ **/
+void bench_map(struct maze* m, char* name) {
+    struct bitboard b;
+    size_t          cells = (size_t)m->width * m->height;
+    uint32_t*       scalar = malloc(cells * sizeof(uint32_t));
+    uint32_t*       wave = malloc(cells * sizeof(uint32_t));
+    uint32_t*       queue = malloc(cells * sizeof(uint32_t));
+    uint32_t        x = m->height / 2 | 1, y = m->width / 2 | 1;
+    double          start, t_scalar, t_wave;
+    long            levels;
+
+    if (scalar == NULL || wave == NULL || queue == NULL || init_bitboard(&b, m)) {
+        printf("Out of memory.\n");
+        exit(-1);
+    }
+
+    start = now();
+    scalar_bfs(m, x, y, scalar, queue);
+    t_scalar = now() - start;
+
+    start = now();
+    levels = distance_map(&b, x, y, wave);
+    t_wave = now() - start;
+
+    printf("%-8s scalar bfs %8.3f s   wavefront %8.3f s   speedup %5.2fx   %ld steps%s\n",
+            name, t_scalar, t_wave, t_scalar / t_wave, levels,
+            memcmp(scalar, wave, cells * sizeof(uint32_t)) ? " (MISMATCH)" : "");
+
+    free_bitboard(&b);
+    free(queue);
+    free(wave);
+    free(scalar);
+}
+
+int main(int argc, char* argv[]) {
+    struct maze m;
+    uint32_t    size = DEFAULT_SIZE;
+    uint32_t    i, j;
+
+    if (argc > 1)
+        size = atoi(argv[1]);
+    if (size < 3 || !(size % 2)) {
+        printf("The size must be odd and at least 3.\n");
+        exit(-1);
+    }
+
+    if (init_maze(&m, size, size)) {
+        printf("Out of memory.\n");
+        exit(-1);
+    }
+    printf("maze %ux%u\n", size, size);
+
+    create_maze(&m, SEED);
+    bench_map(&m, "maze");
+
+    // a room without inner walls: the wavefront is wide
+    for (i = 1; i + 1 < size; i++)
+        for (j = 1; j + 1 < size; j++)
+            CELL(&m, i, j) &= ~CELL_WALL;
+    bench_map(&m, "room");
+
+    free_maze(&m);
+    return 0;
+}
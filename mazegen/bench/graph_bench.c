@@ -0,0 +1,151 @@
+/**
+ * GRAPH_BENCH
+ * Measure the size of the junction graph of a maze and the time needed
+ * to build it, then compare a search on the graph (Dijkstra) with a
+ * breadth-first search on the blocks between the same two vertices.
+ *
+ * Compile: make bench
+ * Usage: ./graph_bench [size]
+ */
+
+#include "../lib/maze.h"
+#include "../lib/graph.h"
+#include "../lib/solver.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define DEFAULT_SIZE        4001
+#define SEED                1
+
+/**
+ * Return the current time in seconds
+ * [OUT] double: monotonic time
+ **/
+double now(void) {
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+/**
+ * Shortest distance between two vertices, with a binary heap of
+ * (distance, vertex) pairs packed into 64 bits
+ * [IN] struct junction_graph*: the graph
+ * [IN] uint32_t: source vertex
+ * [IN] uint32_t: target vertex
+ * [OUT] long: distance in blocks, -1 if unreachable
+ **/
+long dijkstra(struct junction_graph* g, uint32_t source, uint32_t target) {
+    uint32_t*   dist = malloc(g->vertices * sizeof(uint32_t));
+    uint64_t*   heap = malloc(((size_t)g->edges + 1) * sizeof(uint64_t));
+    size_t      n = 0, i, c;
+    uint64_t    top, item;
+    uint32_t    v, e, d;
+    long        found = -1;
+
+    if (dist == NULL || heap == NULL) {
+        printf("Out of memory.\n");
+        exit(-1);
+    }
+    for (v = 0; v < g->vertices; v++)
+        dist[v] = UINT32_MAX;
+
+    dist[source] = 0;
+    heap[n++] = source;
+    while (n > 0) {
+        // pop the closest vertex
+        top = heap[0];
+        item = heap[--n];
+        for (i = 0; (c = 2 * i + 1) < n; i = c) {
+            if (c + 1 < n && heap[c + 1] < heap[c])
+                c++;
+            if (item <= heap[c])
+                break;
+            heap[i] = heap[c];
+        }
+        heap[i] = item;
+
+        v = (uint32_t)top;
+        if ((top >> 32) != dist[v])
+            continue;
+        if (v == target) {
+            found = dist[v];
+            break;
+        }
+
+        // push the vertices it improves
+        for (e = g->first[v]; e < g->first[v + 1]; e++) {
+            d = dist[v] + g->weight[e];
+            if (d >= dist[g->target[e]])
+                continue;
+            dist[g->target[e]] = d;
+            item = (uint64_t)d << 32 | g->target[e];
+            for (i = n++; i > 0 && heap[(i - 1) / 2] > item; i = (i - 1) / 2)
+                heap[i] = heap[(i - 1) / 2];
+            heap[i] = item;
+        }
+    }
+
+    free(heap);
+    free(dist);
+    return found;
+}
+
+int main(int argc, char* argv[]) {
+    struct maze             m;
+    struct junction_graph   g;
+    struct solver           s;
+    uint32_t                size = DEFAULT_SIZE;
+    uint32_t                a, b;
+    size_t                  blocks = 0, i;
+    double                  start, build, graph, search;
+    long                    d_graph, d_search;
+
+    if (argc > 1)
+        size = atoi(argv[1]);
+    if (size < 3 || !(size % 2)) {
+        printf("The size must be odd and at least 3.\n");
+        exit(-1);
+    }
+
+    if (init_maze(&m, size, size) || init_solver(&s, &m)) {
+        printf("Out of memory.\n");
+        exit(-1);
+    }
+    create_maze(&m, SEED);
+    for (i = 0; i < (size_t)size * size; i++)
+        blocks += !(m.cells[i] & CELL_WALL);
+
+    start = now();
+    if (init_graph(&g, &m)) {
+        printf("Out of memory.\n");
+        exit(-1);
+    }
+    build = now() - start;
+
+    // from the first to the last vertex
+    a = 0;
+    b = g.vertices - 1;
+
+    start = now();
+    d_graph = dijkstra(&g, a, b);
+    graph = now() - start;
+
+    start = now();
+    d_search = solve_bfs(&s, g.block[a] / size, g.block[a] % size,
+            g.block[b] / size, g.block[b] % size) - 1;
+    search = now() - start;
+
+    printf("maze %ux%u, %zu free blocks\n", size, size, blocks);
+    printf("graph %u vertices, %u edges (%.1fx fewer nodes), built in %.3f s\n",
+            g.vertices, g.edges, (double)blocks / g.vertices, build);
+    printf("dijkstra on graph    %8.3f s   distance %ld\n", graph, d_graph);
+    printf("bfs on blocks        %8.3f s   distance %ld\n", search, d_search);
+
+    free_graph(&g);
+    free_solver(&s);
+    free_maze(&m);
+    return 0;
+}
@@ -0,0 +1,85 @@
+/**
+ * MAZE_BENCH
+ * Measure the time needed to generate a maze with the sequential
+ * depth-first-search and the speedup of the tiled generator for
+ * an increasing number of threads.
+ *
+ * Compile: make bench
+ * Usage: ./maze_bench [size] [max threads]
+ */
+
+#include "../lib/maze.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#define DEFAULT_SIZE        4001
+#define SEED                1
+
+/**
+ * Return the current time in seconds
+ * [OUT] double: monotonic time
+ **/
+double now(void) {
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+/**
+ * Generate a maze and return the time needed (initialization excluded)
+ * [IN] uint32_t: maze side
+ * [IN] int: number of threads (0 for the sequential generator)
+ * [OUT] double: seconds
+ **/
+double bench_maze(uint32_t size, int threads) {
+    struct maze m;
+    double      start, elapsed;
+
+    if (init_maze(&m, size, size)) {
+        printf("Out of memory.\n");
+        exit(-1);
+    }
+
+    start = now();
+    if (threads == 0)
+        create_maze(&m, SEED);
+    else if (create_maze_tiled(&m, SEED, TILE_NODES, threads)) {
+        printf("Out of memory.\n");
+        exit(-1);
+    }
+    elapsed = now() - start;
+
+    free_maze(&m);
+    return elapsed;
+}
+
+int main(int argc, char* argv[]) {
+    uint32_t    size = DEFAULT_SIZE;
+    int         max_threads = sysconf(_SC_NPROCESSORS_ONLN);
+    int         threads;
+    double      sequential, single, elapsed;
+
+    if (argc > 1)
+        size = atoi(argv[1]);
+    if (argc > 2)
+        max_threads = atoi(argv[2]);
+    if (max_threads < 1)
+        max_threads = 1;
+
+    printf("maze %ux%u, tiles of %u nodes\n", size, size, TILE_NODES);
+
+    sequential = bench_maze(size, 0);
+    printf("%-20s %8.3f s\n", "sequential dfs", sequential);
+
+    single = bench_maze(size, 1);
+    for (threads = 1; threads <= max_threads; threads *= 2) {
+        elapsed = threads == 1 ? single : bench_maze(size, threads);
+        printf("tiled %2d threads     %8.3f s   speedup %5.2fx (vs dfs %5.2fx)\n",
+                threads, elapsed, single / elapsed, sequential / elapsed);
+    }
+
+    return 0;
+}
@@ -0,0 +1,217 @@
+/**
+ * SDF_BENCH
+ * Measure the throughput (MB/s) of the SDF parser stages
+ * on a world file.
+ *
+ * Compile: make bench
+ * Usage: ./sdf_bench [file] [iterations]
+ */
+
+#include "../lib/sdfparser.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#define DEFAULT_FILE        "../worlds/maze.world"
+#define DEFAULT_ITERATIONS  20
+
+/**
+ * Return the current time in seconds
+ * [OUT] double: monotonic time
+ **/
+double now(void) {
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+/**
+ * Measure the throughput of the structural scanner
+ * [IN] struct sdf_file*: file to be indexed
+ * [IN] enum sdf_scanner: implementation to be measured
+ * [IN] int: number of iterations
+ * [OUT] void
+ **/
+void bench_scanner(struct sdf_file* f, enum sdf_scanner scanner, char* name, int iterations) {
+    struct sdf_structure    s;
+    double                  start, elapsed;
+    int                     i;
+
+    start = now();
+    for (i = 0; i < iterations; i++) {
+        if (sdf_structure_build(&s, f->buffer, f->length, scanner) != scanner) {
+            printf("%-20s not supported\n", name);
+            sdf_structure_free(&s);
+            return;
+        }
+        sdf_structure_free(&s);
+    }
+    elapsed = now() - start;
+
+    printf("%-20s %10.1f MB/s\n", name, f->length * (double)iterations / elapsed / 1e6);
+}
+
+/**
+ * Measure the throughput of the whole parser (index and DOM)
+ * [IN] struct sdf_file*: file to be parsed
+ * [IN] int: number of iterations
+ * [OUT] void
+ **/
+void bench_parser(struct sdf_file* f, int iterations) {
+    struct sdf_document d;
+    double              start, elapsed;
+    int                 i;
+
+    start = now();
+    for (i = 0; i < iterations; i++) {
+        sdf_document_create(f, &d);
+        sdf_document_close(&d);
+    }
+    elapsed = now() - start;
+
+    printf("%-20s %10.1f MB/s\n", "document create", f->length * (double)iterations / elapsed / 1e6);
+}
+
+/**
+ * Measure the throughput of the parallel parser
+ * [IN] struct sdf_file*: file to be parsed
+ * [IN] int: number of threads
+ * [IN] int: number of iterations
+ * [OUT] void
+ **/
+void bench_parser_parallel(struct sdf_file* f, int threads, int iterations) {
+    struct sdf_document d;
+    double              start, elapsed;
+    char                name[32];
+    int                 i;
+
+    start = now();
+    for (i = 0; i < iterations; i++) {
+        sdf_document_create_parallel(f, &d, threads);
+        sdf_document_close(&d);
+    }
+    elapsed = now() - start;
+
+    snprintf(name, sizeof(name), "document create x%d", threads);
+    printf("%-20s %10.1f MB/s\n", name, f->length * (double)iterations / elapsed / 1e6);
+}
+
+/**
+ * Measure the throughput of the printer, with one and more threads
+ * [IN] struct sdf_file*: file to be parsed and printed
+ * [IN] int: number of threads
+ * [IN] int: number of iterations
+ * [OUT] void
+ **/
+void bench_print(struct sdf_file* f, int threads, int iterations) {
+    struct sdf_document d;
+    double              start, elapsed;
+    char                name[32];
+    int                 i;
+
+    sdf_document_create(f, &d);
+
+    start = now();
+    for (i = 0; i < iterations; i++)
+        sdf_document_print(&d, "/dev/null");
+    elapsed = now() - start;
+    printf("%-20s %10.1f MB/s\n", "document print", f->length * (double)iterations / elapsed / 1e6);
+
+    start = now();
+    for (i = 0; i < iterations; i++)
+        sdf_document_print_parallel(&d, "/dev/null", threads);
+    elapsed = now() - start;
+    snprintf(name, sizeof(name), "document print x%d", threads);
+    printf("%-20s %10.1f MB/s\n", name, f->length * (double)iterations / elapsed / 1e6);
+
+    sdf_document_close(&d);
+}
+
+/**
+ * Measure the throughput of the pull parser, the file is fed in
+ * chunks as if it was read from a stream
+ * [IN] struct sdf_file*: file to be parsed
+ * [IN] int: number of iterations
+ * [OUT] void
+ **/
+void bench_pull(struct sdf_file* f, int iterations) {
+    struct sdf_pull_parser  p;
+    enum sdf_event          e;
+    size_t                  fed;
+    double                  start, elapsed;
+    int                     i;
+
+    start = now();
+    for (i = 0; i < iterations; i++) {
+        sdf_parser_init(&p, 0);
+        fed = 0;
+        while ((e = sdf_parser_next_event(&p)) != SDF_EVENT_END && e != SDF_EVENT_ERROR)
+            if (e == SDF_EVENT_NONE)
+                fed += sdf_parser_feed(&p, f->buffer + fed, f->length - fed);
+        if (e == SDF_EVENT_ERROR)
+            printf("pull parser: %s\n", p.error);
+        sdf_parser_close(&p);
+    }
+    elapsed = now() - start;
+
+    printf("%-20s %10.1f MB/s\n", "pull parser", f->length * (double)iterations / elapsed / 1e6);
+}
+
+/**
+ * Measure the time of a compiled query that walks every model of the
+ * world and matches none (the worst case: all the branches are tried)
+ * [IN] struct sdf_file*: file to be parsed
+ * [IN] int: number of iterations
+ * [OUT] void
+ **/
+void bench_query(struct sdf_file* f, int iterations) {
+    struct sdf_document d;
+    struct sdf_query    q;
+    double              start, elapsed;
+    int                 i;
+
+    sdf_document_create(f, &d);
+    sdf_query_compile(&q, "sdf/world/model[@name]/link/visual/geometry/box/normal");
+
+    start = now();
+    for (i = 0; i < iterations; i++)
+        if (sdf_query_run(&q, &d, d.root) != SDF_NONE)
+            printf("unexpected match\n");
+    elapsed = now() - start;
+
+    printf("%-20s %10.1f us\n", "query (no match)", elapsed / iterations * 1e6);
+
+    sdf_query_free(&q);
+    sdf_document_close(&d);
+}
+
+int main(int argc, char* argv[]) {
+    struct sdf_file f;
+    char*           filename = DEFAULT_FILE;
+    int             iterations = DEFAULT_ITERATIONS;
+
+    if (argc > 1)
+        filename = argv[1];
+    if (argc > 2)
+        iterations = atoi(argv[2]);
+
+    if (sdf_file_open(&f, filename)) {
+        fprintf(stderr, "ERROR: unable to open %s\n", filename);
+        return -1;
+    }
+
+    printf("%s: %zu bytes, %d iterations\n", filename, f.length, iterations);
+    bench_scanner(&f, SDF_SCAN_SCALAR, "scanner scalar", iterations);
+    bench_scanner(&f, SDF_SCAN_SSE2, "scanner sse2", iterations);
+    bench_scanner(&f, SDF_SCAN_AVX2, "scanner avx2", iterations);
+    bench_parser(&f, iterations);
+    bench_parser_parallel(&f, sysconf(_SC_NPROCESSORS_ONLN), iterations);
+    bench_print(&f, sysconf(_SC_NPROCESSORS_ONLN), iterations);
+    bench_pull(&f, iterations);
+    bench_query(&f, iterations);
+
+    sdf_file_close(&f);
+    return 0;
+}
@@ -0,0 +1,119 @@
+/**
+ * SOLVER_BENCH
+ * Measure the time needed to find the path between two opposite
+ * corners of a maze with each solver. Every solver is run twice
+ * on the same scratch buffers: the second run allocates nothing.
+ *
+ * Compile: make bench
+ * Usage: ./solver_bench [size]
+ */
+
+#include "../lib/maze.h"
+#include "../lib/solver.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define DEFAULT_SIZE        10001
+#define SEED                1
+
+typedef long (*solve_fn)(struct solver*, uint32_t, uint32_t, uint32_t, uint32_t);
+
+/**
+ * Return the current time in seconds
+ * [OUT] double: monotonic time
+ **/
+double now(void) {
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+/**
+ * Check that each block of the path is free and next to the previous one
+ * [IN] struct solver*: solver that found the path
+ * [OUT] int: 1 if the path can be walked, 0 otherwise
+ **/
+int check_path(struct solver* s) {
+    uint32_t    width = s->m->width;
+    uint32_t    a, b;
+    size_t      k;
+
+    for (k = 0; k < s->length; k++) {
+        b = s->path[k];
+        if (s->m->cells[b] & CELL_WALL)
+            return 0;
+        if (k == 0)
+            continue;
+        a = s->path[k - 1];
+        if (!(a + 1 == b || b + 1 == a) && !(a + width == b || b + width == a))
+            return 0;
+    }
+
+    return 1;
+}
+
+/**
+ * Solve the maze twice with a solver and print the time of both runs
+ * [IN] struct solver*: scratch buffers
+ * [IN] char*: name of the solver
+ * [IN] solve_fn: the solver
+ * [OUT] long: blocks of the path
+ **/
+long bench_solver(struct solver* s, char* name, solve_fn solve) {
+    struct maze*    m = s->m;
+    double          first, second, start;
+    long            len;
+
+    start = now();
+    len = solve(s, 1, 1, m->height - 2, m->width - 2);
+    first = now() - start;
+
+    start = now();
+    len = solve(s, 1, 1, m->height - 2, m->width - 2);
+    second = now() - start;
+
+    if (len < 0) {
+        printf("Out of memory.\n");
+        exit(-1);
+    }
+    printf("%-20s %8.3f s %8.3f s   path %ld blocks%s\n", name, first, second, len,
+            check_path(s) ? "" : " (INVALID)");
+
+    return len;
+}
+
+int main(int argc, char* argv[]) {
+    struct maze     m;
+    struct solver   s;
+    uint32_t        size = DEFAULT_SIZE;
+    long            bfs, astar, dead_end;
+
+    if (argc > 1)
+        size = atoi(argv[1]);
+    if (size < 3 || !(size % 2)) {
+        printf("The size must be odd and at least 3.\n");
+        exit(-1);
+    }
+
+    if (init_maze(&m, size, size) || init_solver(&s, &m)) {
+        printf("Out of memory.\n");
+        exit(-1);
+    }
+    create_maze(&m, SEED);
+
+    printf("maze %ux%u, %zu blocks\n", size, size, (size_t)size * size);
+    printf("%-20s %10s %10s\n", "", "first", "second");
+
+    bfs = bench_solver(&s, "bfs", solve_bfs);
+    astar = bench_solver(&s, "a*", solve_astar);
+    dead_end = bench_solver(&s, "dead-end filling", solve_dead_end);
+
+    if (bfs != astar || bfs != dead_end)
+        printf("The solvers found paths of different length.\n");
+
+    free_solver(&s);
+    free_maze(&m);
+    return 0;
+}
@@ -0,0 +1,110 @@
+/**
+ * TREE_BENCH
+ * Measure the time needed to build the tree of a maze and to answer
+ * random distance queries with it, compared with a search for each
+ * query.
+ *
+ * Compile: make bench
+ * Usage: ./tree_bench [size] [queries]
+ */
+
+#include "../lib/maze.h"
+#include "../lib/rng.h"
+#include "../lib/solver.h"
+#include "../lib/tree.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define DEFAULT_SIZE        4001
+#define DEFAULT_QUERIES     1000000
+#define SEARCHES            20
+#define SEED                1
+
+/**
+ * Return the current time in seconds
+ * [OUT] double: monotonic time
+ **/
+double now(void) {
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+/**
+ * Draw a random node of the maze
+ * [IN] struct rng*: random generator
+ * [IN] uint32_t: maze side
+ * [IN] uint32_t*: x, y position will be left here
+ * [OUT] void
+ **/
+void random_node(struct rng* r, uint32_t size, uint32_t* x, uint32_t* y) {
+    *x = 2 * rng_below(r, size / 2) + 1;
+    *y = 2 * rng_below(r, size / 2) + 1;
+}
+
+int main(int argc, char* argv[]) {
+    struct maze         m;
+    struct maze_tree    t;
+    struct solver       s;
+    struct rng          r;
+    uint32_t            size = DEFAULT_SIZE;
+    long                queries = DEFAULT_QUERIES;
+    uint32_t            x0, y0, x1, y1;
+    double              start, build, tree, search;
+    long                i, sum = 0, wrong = 0;
+
+    if (argc > 1)
+        size = atoi(argv[1]);
+    if (argc > 2)
+        queries = atol(argv[2]);
+    if (size < 3 || !(size % 2)) {
+        printf("The size must be odd and at least 3.\n");
+        exit(-1);
+    }
+
+    if (init_maze(&m, size, size) || init_solver(&s, &m)) {
+        printf("Out of memory.\n");
+        exit(-1);
+    }
+    create_maze(&m, SEED);
+
+    start = now();
+    if (init_tree(&t, &m)) {
+        printf("Out of memory.\n");
+        exit(-1);
+    }
+    build = now() - start;
+
+    rng_seed(&r, SEED);
+    start = now();
+    for (i = 0; i < queries; i++) {
+        random_node(&r, size, &x0, &y0);
+        random_node(&r, size, &x1, &y1);
+        sum += tree_distance(&t, x0, y0, x1, y1);
+    }
+    tree = now() - start;
+
+    // a few queries answered by a breadth-first search too
+    start = now();
+    for (i = 0; i < SEARCHES; i++) {
+        random_node(&r, size, &x0, &y0);
+        random_node(&r, size, &x1, &y1);
+        if (solve_bfs(&s, x0, y0, x1, y1) - 1 != tree_distance(&t, x0, y0, x1, y1))
+            wrong++;
+    }
+    search = (now() - start) / SEARCHES;
+
+    printf("maze %ux%u\n", size, size);
+    printf("build tree           %8.3f s\n", build);
+    printf("tree query           %8.3f us   (%ld queries, mean distance %.0f)\n",
+            tree / queries * 1e6, queries, (double)sum / queries);
+    printf("bfs query            %8.3f us   (%d queries, %ld wrong)\n",
+            search * 1e6, SEARCHES, wrong);
+
+    free_tree(&t);
+    free_solver(&s);
+    free_maze(&m);
+    return 0;
+}
@@ -0,0 +1,273 @@
+/**
+ * BITBOARD
+ * Maze stored as a bitboard (64 blocks for each word) and
+ * bit-parallel wavefront search of the distance of each block
+ */
+
+#include "bitboard.h"
+#include <stdlib.h>
+#include <string.h>
+#include <immintrin.h>
+
+# define DENSE_RATIO    16          // the whole board is expanded when the
+                                    // wavefront has more than 1/16 of its words
+
+// -----------------------------------------------------
+// PRIVATE METHOD
+// -----------------------------------------------------
+
+/**
+ * Add bits to a word of the next board, listing the word the
+ * first time it gets a bit
+ *
+ * [IN]     bitboard*: pointer to the bitboard struct
+ * [IN]     size_t: word of the board
+ * [IN]     uint64_t: blocks reached from the wavefront
+ * [IN]     size_t*: number of words listed in next_list
+ * [OUT]    void
+ */
+static inline void reach(struct bitboard* b, size_t i, uint64_t bits, size_t* n) {
+    bits &= b->open[i] & ~b->visited[i];
+    if (bits == 0)
+        return;
+    if (b->next[i] == 0)
+        b->next_list[(*n)++] = i;
+    b->next[i] |= bits;
+}
+
+/**
+ * Expand only the words of the wavefront: each block reaches the blocks
+ * on its sides in the same word (or the first/last bit of the
+ * words around) and the blocks above and below it
+ *
+ * [IN]     bitboard*: pointer to the bitboard struct
+ * [IN]     size_t: number of words of the wavefront
+ * [OUT]    size_t: number of words of the next wavefront
+ */
+static size_t expand_sparse(struct bitboard* b, size_t n_front) {
+    size_t      k, i, n = 0;
+    uint64_t    f;
+
+    for (k = 0; k < n_front; k++) {
+        i = b->list[k];
+        f = b->front[i];
+        reach(b, i, f << 1 | f >> 1, &n);
+        reach(b, i - 1, f << 63, &n);
+        reach(b, i + 1, f >> 63, &n);
+        reach(b, i - b->stride, f, &n);
+        reach(b, i + b->stride, f, &n);
+    }
+
+    return n;
+}
+
+/**
+ * Expand the whole board, one word at a time
+ *
+ * [IN]     bitboard*: pointer to the bitboard struct
+ * [IN]     size_t: first word to be expanded
+ * [IN]     size_t: last word to be expanded (excluded)
+ * [OUT]    void
+ */
+static void expand_words(struct bitboard* b, size_t first, size_t last) {
+    uint64_t*   f = b->front;
+    size_t      s = b->stride;
+    size_t      i;
+
+    for (i = first; i < last; i++)
+        b->next[i] = (f[i] << 1 | f[i - 1] >> 63 | f[i] >> 1 | f[i + 1] << 63 |
+                f[i - s] | f[i + s]) & b->open[i] & ~b->visited[i];
+}
+
+/**
+ * Expand the whole board, four words at a time with AVX2
+ *
+ * [IN]     bitboard*: pointer to the bitboard struct
+ * [IN]     size_t: first word to be expanded
+ * [IN]     size_t: last word to be expanded (excluded)
+ * [OUT]    size_t: first word not expanded
+ */
+__attribute__((target("avx2")))
+static size_t expand_words_avx2(struct bitboard* b, size_t first, size_t last) {
+    uint64_t*   f = b->front;
+    size_t      s = b->stride;
+    size_t      i;
+    __m256i     c, l, r, up, down, n;
+
+    for (i = first; i + 4 <= last; i += 4) {
+        c = _mm256_loadu_si256((__m256i*)(f + i));
+        l = _mm256_loadu_si256((__m256i*)(f + i - 1));
+        r = _mm256_loadu_si256((__m256i*)(f + i + 1));
+        up = _mm256_loadu_si256((__m256i*)(f + i - s));
+        down = _mm256_loadu_si256((__m256i*)(f + i + s));
+
+        // sides (carrying the bits across words), then above and below
+        n = _mm256_or_si256(_mm256_slli_epi64(c, 1), _mm256_srli_epi64(l, 63));
+        n = _mm256_or_si256(n, _mm256_srli_epi64(c, 1));
+        n = _mm256_or_si256(n, _mm256_slli_epi64(r, 63));
+        n = _mm256_or_si256(n, _mm256_or_si256(up, down));
+
+        // only free blocks not yet reached
+        n = _mm256_and_si256(n, _mm256_loadu_si256((__m256i*)(b->open + i)));
+        n = _mm256_andnot_si256(_mm256_loadu_si256((__m256i*)(b->visited + i)), n);
+        _mm256_storeu_si256((__m256i*)(b->next + i), n);
+    }
+
+    return i;
+}
+
+/**
+ * Expand the whole board and list the words of the next wavefront
+ *
+ * [IN]     bitboard*: pointer to the bitboard struct
+ * [OUT]    size_t: number of words of the next wavefront
+ */
+static size_t expand_dense(struct bitboard* b) {
+    size_t  first = b->stride;                  // the maze starts after the empty row
+    size_t  last = b->words - b->stride;        // and ends before the other one
+    size_t  i, n = 0;
+
+    i = first;
+    if (__builtin_cpu_supports("avx2"))
+        i = expand_words_avx2(b, first, last);
+    expand_words(b, i, last);
+
+    for (i = first; i < last; i++)
+        if (b->next[i])
+            b->next_list[n++] = i;
+
+    return n;
+}
+
+// -----------------------------------------------------
+// PUBLIC METHOD
+// -----------------------------------------------------
+
+/**
+ * Init the bitboard of a maze
+ *
+ * [IN]     bitboard*: pointer to the bitboard to be initialized
+ * [IN]     maze*: pointer to the maze struct
+ * [OUT]    int: -1 in case of low mem availability, 0 in case of success
+ */
+int init_bitboard(struct bitboard* b, struct maze* m) {
+    uint64_t*   row;
+    uint32_t    x, y;
+
+    b->width = m->width;
+    b->height = m->height;
+    b->stride = ((size_t)m->width + 63) / 64 + 1;
+    b->words = ((size_t)m->height + 2) * b->stride;
+
+    // a few more words, so that the last vector loads stay inside
+    b->open = calloc(b->words + 4, sizeof(uint64_t));
+    b->visited = calloc(b->words + 4, sizeof(uint64_t));
+    b->front = calloc(b->words + 4, sizeof(uint64_t));
+    b->next = calloc(b->words + 4, sizeof(uint64_t));
+    b->list = malloc(b->words * sizeof(uint32_t));
+    b->next_list = malloc(b->words * sizeof(uint32_t));
+
+    // out of memory
+    if (b->words > UINT32_MAX || b->open == NULL || b->visited == NULL || b->front == NULL ||
+            b->next == NULL || b->list == NULL || b->next_list == NULL) {
+        free_bitboard(b);
+        return -1;
+    }
+
+    // one bit for each free block
+    for (x = 0; x < m->height; x++) {
+        row = b->open + (x + 1) * b->stride;
+        for (y = 0; y < m->width; y++)
+            if (!(CELL(m, x, y) & CELL_WALL))
+                row[y / 64] |= 1ULL << (y % 64);
+    }
+
+    return 0;
+}
+
+/**
+ * Free the memory allocated for the bitboard
+ *
+ * [IN]     bitboard*: pointer to the bitboard struct
+ * [OUT]    void
+ */
+void free_bitboard(struct bitboard* b) {
+    free(b->open);
+    free(b->visited);
+    free(b->front);
+    free(b->next);
+    free(b->list);
+    free(b->next_list);
+    b->open = b->visited = b->front = b->next = NULL;
+    b->list = b->next_list = NULL;
+}
+
+/**
+ * Compute the distance of each block from the goal. The whole wavefront
+ * moves one step at a time using shifts and masks on 64 blocks at once:
+ * when it is small only its words are expanded, when it is large the
+ * whole board is expanded (with AVX2 when available)
+ *
+ * [IN]     bitboard*: pointer to the bitboard struct
+ * [IN]     uint32_t: goal position (x, y)
+ * [IN]     uint32_t*: width * height distances will be left here, row
+ *                     by row (DIST_NONE for walls and unreachable blocks)
+ * [OUT]    long: largest distance, -1 if the goal is not a free block
+ */
+long distance_map(struct bitboard* b, uint32_t x, uint32_t y, uint32_t* dist) {
+    size_t      i, k, n_front, n_next;
+    size_t      row, col;
+    uint32_t*   list;
+    uint64_t*   board;
+    uint64_t    bits;
+    uint32_t    d;
+
+    i = (x + 1) * b->stride + y / 64;
+    if (x >= b->height || y >= b->width || !(b->open[i] >> (y % 64) & 1))
+        return -1;
+
+    for (k = 0; k < (size_t)b->width * b->height; k++)
+        dist[k] = DIST_NONE;
+    memset(b->visited, 0, b->words * sizeof(uint64_t));
+
+    // the wavefront starts from the goal
+    b->front[i] = b->visited[i] = 1ULL << (y % 64);
+    b->list[0] = i;
+    n_front = 1;
+    dist[(size_t)x * b->width + y] = 0;
+
+    for (d = 1; ; d++) {
+        if (n_front * DENSE_RATIO > b->words)
+            n_next = expand_dense(b);
+        else
+            n_next = expand_sparse(b, n_front);
+
+        // the old wavefront is no longer needed
+        for (k = 0; k < n_front; k++)
+            b->front[b->list[k]] = 0;
+        if (n_next == 0)
+            break;
+
+        // the blocks just reached are at distance d
+        for (k = 0; k < n_next; k++) {
+            i = b->next_list[k];
+            bits = b->next[i];
+            b->visited[i] |= bits;
+            row = i / b->stride - 1;
+            col = i % b->stride * 64;
+            for (; bits; bits &= bits - 1)
+                dist[row * b->width + col + __builtin_ctzll(bits)] = d;
+        }
+
+        // the next wavefront becomes the current one
+        board = b->front;
+        b->front = b->next;
+        b->next = board;
+        list = b->list;
+        b->list = b->next_list;
+        b->next_list = list;
+        n_front = n_next;
+    }
+
+    return d - 1;
+}
@@ -0,0 +1,92 @@
+/**
+ * BITBOARD
+ * Maze stored as a bitboard (64 blocks for each word) and
+ * bit-parallel wavefront search of the distance of each block
+ *
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2018, Gabriele Ara, Gabriele Serra
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef BITBOARD_H
+#define BITBOARD_H
+
+#include "maze.h"
+
+# define DIST_NONE      UINT32_MAX  // distance of walls and unreachable blocks
+
+/**
+ * STRUCT BITBOARD
+ * Free blocks of a maze, one bit for each block, and the boards of the
+ * wavefront search. Each row of the maze takes (width + 63) / 64 words
+ * followed by an empty word, and an empty row is kept above and below
+ * the maze, so that shifts never leak into the next row or outside
+ */
+struct bitboard {
+    uint64_t*       open;       // free blocks
+    uint64_t*       visited;    // blocks already reached
+    uint64_t*       front;      // blocks reached at the last step
+    uint64_t*       next;       // blocks reached at this step
+    uint32_t*       list;       // non-empty words of front
+    uint32_t*       next_list;  // non-empty words of next
+    uint32_t        width;      // maze width (number of block)
+    uint32_t        height;     // maze height (number of block)
+    size_t          stride;     // words of each row
+    size_t          words;      // words of each board
+};
+
+/**
+ * Init the bitboard of a maze
+ * 
+ * [IN]     bitboard*: pointer to the bitboard to be initialized
+ * [IN]     maze*: pointer to the maze struct
+ * [OUT]    int: -1 in case of low mem availability, 0 in case of success
+ */
+int init_bitboard(struct bitboard* b, struct maze* m);
+
+/**
+ * Free the memory allocated for the bitboard
+ * 
+ * [IN]     bitboard*: pointer to the bitboard struct
+ * [OUT]    void
+ */
+void free_bitboard(struct bitboard* b);
+
+/**
+ * Compute the distance of each block from the goal. The whole wavefront
+ * moves one step at a time using shifts and masks on 64 blocks at once:
+ * when it is small only its words are expanded, when it is large the
+ * whole board is expanded (with AVX2 when available)
+ * 
+ * [IN]     bitboard*: pointer to the bitboard struct
+ * [IN]     uint32_t: goal position (x, y)
+ * [IN]     uint32_t*: width * height distances will be left here, row
+ *                     by row (DIST_NONE for walls and unreachable blocks)
+ * [OUT]    long: largest distance, -1 if the goal is not a free block
+ */
+long distance_map(struct bitboard* b, uint32_t x, uint32_t y, uint32_t* dist);
+
+
+#endif
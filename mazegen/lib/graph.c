@@ -0,0 +1,222 @@
+/**
+ * GRAPH
+ * Maze collapsed into a weighted graph of junctions and dead
+ * ends, stored in compressed sparse row format
+ */
+
+#include "graph.h"
+#include <stdlib.h>
+
+// -----------------------------------------------------
+// PRIVATE METHOD
+// -----------------------------------------------------
+
+/**
+ * Step along x and y for each direction (bit index of the direction)
+ */
+static const int step_x[4] = {1, 0, -1, 0};
+static const int step_y[4] = {0, 1, 0, -1};
+
+/**
+ * Get the free neighbors of a block
+ *
+ * [IN]     maze*: pointer to the maze struct
+ * [IN]     uint32_t: block position (x, y)
+ * [OUT]    uint8_t: a direction bit for each free neighbor
+ */
+static uint8_t free_dirs(struct maze* m, uint32_t x, uint32_t y) {
+    uint8_t dirs = NO_DIR;
+
+    if (x + 1 < m->height && !(CELL(m, x + 1, y) & CELL_WALL))
+        dirs |= RIGHT_DIR;
+    if (y + 1 < m->width && !(CELL(m, x, y + 1) & CELL_WALL))
+        dirs |= DOWN_DIR;
+    if (x > 0 && !(CELL(m, x - 1, y) & CELL_WALL))
+        dirs |= LEFT_DIR;
+    if (y > 0 && !(CELL(m, x, y - 1) & CELL_WALL))
+        dirs |= UP_DIR;
+
+    return dirs;
+}
+
+/**
+ * A free block is a vertex unless it has exactly two free neighbors
+ *
+ * [IN]     maze*: pointer to the maze struct
+ * [IN]     uint32_t: block position (x, y)
+ * [OUT]    int: 1 if the block is a vertex, 0 otherwise
+ */
+static int is_vertex(struct maze* m, uint32_t x, uint32_t y) {
+    return !(CELL(m, x, y) & CELL_WALL) && __builtin_popcount(free_dirs(m, x, y)) != 2;
+}
+
+/**
+ * Walk a corridor from a vertex until the next vertex
+ *
+ * [IN]     maze*: pointer to the maze struct
+ * [IN]     uint32_t*: position (x, y) of the vertex, the position of the
+ *                     vertex reached will be left here
+ * [IN]     int: bit index of the direction of the first step
+ * [IN]     uint32_t*: if not NULL, the blocks walked (vertices included)
+ *                     will be left here
+ * [OUT]    uint32_t: blocks walked
+ */
+static uint32_t walk_corridor(struct maze* m, uint32_t* x, uint32_t* y, int dir, uint32_t* path) {
+    uint32_t    steps = 0;
+    uint8_t     dirs;
+
+    if (path != NULL)
+        path[0] = *x * m->width + *y;
+
+    do {
+        *x += step_x[dir];
+        *y += step_y[dir];
+        steps++;
+        if (path != NULL)
+            path[steps] = *x * m->width + *y;
+
+        // go on towards the other free neighbor
+        dirs = free_dirs(m, *x, *y);
+        if (__builtin_popcount(dirs) != 2)
+            break;
+        dir = __builtin_ctz(dirs & ~(1 << ((dir + 2) % 4)));
+    } while (1);
+
+    return steps;
+}
+
+// -----------------------------------------------------
+// PUBLIC METHOD
+// -----------------------------------------------------
+
+/**
+ * Build the graph of a maze. The maze can't change until the graph is freed
+ *
+ * [IN]     junction_graph*: pointer to the graph to be initialized
+ * [IN]     maze*: pointer to the maze struct
+ * [OUT]    int: -1 in case of low mem availability, 0 in case of success
+ */
+int init_graph(struct junction_graph* g, struct maze* m) {
+    size_t      vertices = 0, edges = 0;
+    uint32_t    x, y, tx, ty;
+    uint32_t    v, e;
+    uint8_t     dirs;
+    int         dir;
+
+    g->m = m;
+    g->block = g->first = g->target = g->weight = NULL;
+    g->dir = NULL;
+
+    // count vertices and edges
+    for (x = 0; x < m->height; x++)
+        for (y = 0; y < m->width; y++)
+            if (is_vertex(m, x, y)) {
+                vertices++;
+                edges += __builtin_popcount(free_dirs(m, x, y));
+            }
+
+    if (edges > UINT32_MAX || (size_t)m->width * m->height > UINT32_MAX)
+        return -1;
+    g->vertices = vertices;
+    g->edges = edges;
+
+    g->block = malloc(vertices * sizeof(uint32_t));
+    g->first = malloc((vertices + 1) * sizeof(uint32_t));
+    g->target = malloc(edges * sizeof(uint32_t));
+    g->weight = malloc(edges * sizeof(uint32_t));
+    g->dir = malloc(edges);
+
+    // out of memory
+    if (g->block == NULL || g->first == NULL || g->target == NULL ||
+            g->weight == NULL || g->dir == NULL) {
+        free_graph(g);
+        return -1;
+    }
+
+    // vertices are listed row by row, so their blocks are sorted
+    v = e = 0;
+    for (x = 0; x < m->height; x++)
+        for (y = 0; y < m->width; y++)
+            if (is_vertex(m, x, y)) {
+                g->block[v] = x * m->width + y;
+                g->first[v++] = e;
+                e += __builtin_popcount(free_dirs(m, x, y));
+            }
+    g->first[v] = e;
+
+    // walk each corridor from both its ends
+    for (v = 0; v < g->vertices; v++) {
+        x = g->block[v] / m->width;
+        y = g->block[v] % m->width;
+        dirs = free_dirs(m, x, y);
+        for (e = g->first[v]; dirs; e++, dirs &= dirs - 1) {
+            dir = __builtin_ctz(dirs);
+            tx = x;
+            ty = y;
+            g->weight[e] = walk_corridor(m, &tx, &ty, dir, NULL);
+            g->target[e] = graph_vertex(g, tx, ty);
+            g->dir[e] = dir;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Free the memory allocated for the graph
+ *
+ * [IN]     junction_graph*: pointer to the graph struct
+ * [OUT]    void
+ */
+void free_graph(struct junction_graph* g) {
+    free(g->block);
+    free(g->first);
+    free(g->target);
+    free(g->weight);
+    free(g->dir);
+    g->block = g->first = g->target = g->weight = NULL;
+    g->dir = NULL;
+}
+
+/**
+ * Find the vertex of a block, with a binary search
+ *
+ * [IN]     junction_graph*: pointer to the graph struct
+ * [IN]     uint32_t: block position (x, y)
+ * [OUT]    long: the vertex, -1 if the block is not a vertex
+ */
+long graph_vertex(struct junction_graph* g, uint32_t x, uint32_t y) {
+    uint32_t    i = x * g->m->width + y;
+    uint32_t    lo = 0, hi = g->vertices, mid;
+
+    if (x >= g->m->height || y >= g->m->width)
+        return -1;
+
+    while (lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        if (g->block[mid] < i)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    return lo < g->vertices && g->block[lo] == i ? (long)lo : -1;
+}
+
+/**
+ * Turn an edge back into the blocks of its corridor, as their indexes
+ * (x * width + y) from its vertex to the target one (both included)
+ *
+ * [IN]     junction_graph*: pointer to the graph struct
+ * [IN]     uint32_t: vertex the edge leaves
+ * [IN]     uint32_t: the edge
+ * [IN]     uint32_t*: the blocks will be left here, it must have
+ *                     room for weight + 1 blocks
+ * [OUT]    void
+ */
+void graph_corridor(struct junction_graph* g, uint32_t v, uint32_t e, uint32_t* path) {
+    uint32_t x = g->block[v] / g->m->width;
+    uint32_t y = g->block[v] % g->m->width;
+
+    walk_corridor(g->m, &x, &y, g->dir[e], path);
+}
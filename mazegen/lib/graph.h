@@ -0,0 +1,98 @@
+/**
+ * GRAPH
+ * Maze collapsed into a weighted graph of junctions and dead
+ * ends, stored in compressed sparse row format
+ *
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2018, Gabriele Ara, Gabriele Serra
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef GRAPH_H
+#define GRAPH_H
+
+#include "maze.h"
+
+/**
+ * STRUCT JUNCTION_GRAPH
+ * Free blocks that don't have exactly two free neighbors (junctions and
+ * dead ends) are the vertices; the corridors between them are the edges,
+ * weighted by their length. The edges leaving vertex v are the ones from
+ * first[v] to first[v + 1] (excluded); each corridor is stored once for
+ * each end. A corridor is turned back into blocks walking the maze from
+ * its first step. Corridors closed in a loop without vertices are left out
+ */
+struct junction_graph {
+    struct maze*    m;          // the maze
+    uint32_t        vertices;   // number of vertices
+    uint32_t        edges;      // number of edges (both ways)
+    uint32_t*       block;      // index (x * width + y) of each vertex, increasing
+    uint32_t*       first;      // first edge of each vertex (vertices + 1)
+    uint32_t*       target;     // vertex reached by each edge
+    uint32_t*       weight;     // blocks walked along each edge
+    uint8_t*        dir;        // bit index of the direction of the first step
+};
+
+/**
+ * Build the graph of a maze. The maze can't change until the graph is freed
+ * 
+ * [IN]     junction_graph*: pointer to the graph to be initialized
+ * [IN]     maze*: pointer to the maze struct
+ * [OUT]    int: -1 in case of low mem availability, 0 in case of success
+ */
+int init_graph(struct junction_graph* g, struct maze* m);
+
+/**
+ * Free the memory allocated for the graph
+ * 
+ * [IN]     junction_graph*: pointer to the graph struct
+ * [OUT]    void
+ */
+void free_graph(struct junction_graph* g);
+
+/**
+ * Find the vertex of a block, with a binary search
+ * 
+ * [IN]     junction_graph*: pointer to the graph struct
+ * [IN]     uint32_t: block position (x, y)
+ * [OUT]    long: the vertex, -1 if the block is not a vertex
+ */
+long graph_vertex(struct junction_graph* g, uint32_t x, uint32_t y);
+
+/**
+ * Turn an edge back into the blocks of its corridor, as their indexes
+ * (x * width + y) from its vertex to the target one (both included)
+ * 
+ * [IN]     junction_graph*: pointer to the graph struct
+ * [IN]     uint32_t: vertex the edge leaves
+ * [IN]     uint32_t: the edge
+ * [IN]     uint32_t*: the blocks will be left here, it must have
+ *                     room for weight + 1 blocks
+ * [OUT]    void
+ */
+void graph_corridor(struct junction_graph* g, uint32_t v, uint32_t e, uint32_t* path);
+
+
+#endif
@@ -5,130 +5,550 @@
  */
 
 #include "maze.h"
-#include <stdio.h>
+#include "rng.h"
 #include <stdlib.h>
-#include <time.h>
+#include <string.h>
+#include <pthread.h>
 
 // -----------------------------------------------------
 // PRIVATE METHOD
 // -----------------------------------------------------
 
 /**
- * Init a node of the graph 
- * 
- * [IN]     node*: pointer to the node to be initialized as maze component
- * [IN]     uint8_t: node position in the maze (x position)
- * [IN]     uint8_t: node position in the maze (y position)
- * [IN]     uint8_t: explorable directions from the node towards neighbors
- * [IN]     block: primitive type of block (wall, free, ..)
- * [OUT]    void
+ * STRUCT AREA
+ * Rectangle of blocks [x0, x1) x [y0, y1) explored by a single
+ * depth-first-search, nodes are never linked outside of it
  */
-static void init_node(struct node* n, uint8_t i, uint8_t j, uint8_t dirs, enum block type) {
-    n->x = i;
-    n->y = j;
-    n->dirs = dirs;
-    n->type = type;
-}
+struct area {
+    uint32_t        x0, y0; // first block of the area
+    uint32_t        x1, y1; // block after the last one
+};
+
+/**
+ * STRUCT TILE_JOB
+ * Tiles shared among the threads that carve them
+ */
+struct tile_job {
+    struct maze*    m;          // maze to be carved
+    uint64_t        seed;       // seed of the maze
+    uint32_t        tile;       // nodes for each side of a tile
+    uint32_t        tiles_y;    // tiles for each row of tiles
+    uint32_t        tiles;      // number of tiles
+    uint32_t        next;       // next tile to be carved (atomic)
+};
+
+/**
+ * STRUCT TILE_EDGE
+ * Passage that can join two adjacent tiles
+ */
+struct tile_edge {
+    uint32_t        a, b;       // the two tiles
+    uint32_t        ux, uy;     // node of tile a
+    uint32_t        vx, vy;     // node of tile b
+};
 
 /**
- * Remove wall between start and dest node 
- * NOTE: start and dest must be adjacent
+ * Step along x and y for each direction (bit index of the direction)
+ */
+static const int step_x[4] = {1, 0, -1, 0};
+static const int step_y[4] = {0, 1, 0, -1};
+
+/**
+ * Pick uniformly one of the directions set in dirs, with a single
+ * draw: the random index selects the k-th set bit
  * 
- * [IN]     maze*: maze structure
- * [IN]     node*: pointer of first node
- * [OUT]    node*: pointer of second node
+ * [IN]     rng*: random generator
+ * [IN]     uint8_t: directions to choose from (at least one)
+ * [OUT]    uint8_t: the chosen direction
  */
-static void remove_wall(struct maze* m, struct node* start, struct node* dest) {
-    uint8_t         x, y;   // x, y coordinate of node between start and dest
-    struct node*    mid;    // pointer of node between start and dest
-    
-    // compute coordinate of node between start and dest
-    x = start->x + (dest->x - start->x) / 2;
-    y = start->y + (dest->y - start->y) / 2;
+static uint8_t random_dir(struct rng* r, uint8_t dirs) {
+    uint32_t k = rng_below(r, __builtin_popcount(dirs));
+
+    // clear the k lowest set bits, then keep the lowest one
+    for (; k > 0; k--)
+        dirs &= dirs - 1;
 
-    // get node pointer and change type
-    mid = m->graph + (x * m->width) + y;
-    mid->type = NONE;     
+    return dirs & -dirs;
 }
 
 /**
- * Return a pointer to neighbor obtained from "start" following "dir" 
+ * Get the position of the neighbor obtained from (x, y) following "dir"
  * 
- * [IN]     maze*: maze structure
- * [IN]     node*: pointer of start
- * [OUT]    uint8_t: direction of path
+ * [IN]     area*: area in which the neighbor must be
+ * [IN]     uint32_t: start position (x position)
+ * [IN]     uint32_t: start position (y position)
+ * [IN]     int: bit index of the direction of path
+ * [IN]     uint32_t*: neighbor position will be left here (x position)
+ * [IN]     uint32_t*: neighbor position will be left here (y position)
+ * [OUT]    int: 1 if the neighbor exists, 0 otherwise
  */
-static struct node* get_neighbor(struct maze* m, struct node* start, uint8_t dir) {
-    struct node* neighbor = NULL;
-
-    switch (dir) {
+static int get_neighbor(struct area* a, uint32_t x, uint32_t y, int dir, 
+        uint32_t* nx, uint32_t* ny) {
+    switch (1 << dir) {
         case RIGHT_DIR:
-            if (start->x + 2 < m->height)
-                neighbor = m->graph + ((start->x + 2) * m->width) + start->y;
+            if (x + 2 >= a->x1)
+                return 0;
             break;
         case DOWN_DIR:
-            if (start->y + 2 < m->width)
-                neighbor = m->graph + (start->x * m->width) + (start->y + 2);            
+            if (y + 2 >= a->y1)
+                return 0;
             break;        
         case LEFT_DIR:
-            if (start->x - 2 >= 0)
-                neighbor = m->graph + ((start->x - 2) * m->width) + start->y;            
+            if (x < a->x0 + 2)
+                return 0;
             break;        
         case UP_DIR:
-            if (start->y - 2 >= 0)
-                neighbor = m->graph + (start->x * m->width) + (start->y - 2);            
+            if (y < a->y0 + 2)
+                return 0;
             break;
-        default:
-            neighbor = NULL;        
     }
 
-    return neighbor;
+    *nx = x + 2 * step_x[dir];
+    *ny = y + 2 * step_y[dir];
+    return 1;
 }
 
 /**
- * Link the provided node to a random neighbor (if possible) and return
- * the pointer of the neighbor
+ * Link the node at (x, y) to a random neighbor (if possible) and move
+ * the position onto the neighbor, otherwise move it back to the parent
  * 
- * [IN]     node*: pointer to node from which start
- * [OUT]    node*: pointer to neighbor visited
+ * [IN]     maze*: maze structure
+ * [IN]     area*: area explored
+ * [IN]     rng*: random generator
+ * [IN]     uint32_t*: position of the node from which start (x position)
+ * [IN]     uint32_t*: position of the node from which start (y position)
+ * [OUT]    void
  */
-static struct node* link(struct maze* m, struct node* start) {
-	uint8_t         new_dir;    // randomly generated direction
-	struct node*    neighbor;   // pointer to neighbor
-	
-	if (start == NULL) 
-        return NULL;
+static void link(struct maze* m, struct area* a, struct rng* r, uint32_t* x, uint32_t* y) {
+    uint8_t*    start;      // cell from which start
+    uint8_t*    neighbor;   // cell of the neighbor
+    uint8_t     new_dir;    // randomly generated direction
+    int         dir;        // bit index of new_dir
+    uint32_t    nx, ny;     // neighbor position
+    int         code;       // direction code of the parent
+
+    start = &CELL(m, *x, *y);
 	
-	// while there are directions still unexplored
-	while (start->dirs) {
-		new_dir = (1 << (rand() % 4));
-		
-		// if it has already been explored re-try
-		if (new_dir & ~start->dirs) 
-            continue;
+    // while there are directions still unexplored
+    while (*start & CELL_DIRS) {
+        new_dir = random_dir(r, *start & CELL_DIRS);
 		
-		// mark direction as explored and get neighbor
-		start->dirs &= ~new_dir;		
-		neighbor = get_neighbor(m, start, new_dir);
+        // mark direction as explored and get neighbor
+        *start &= ~new_dir;
+        dir = __builtin_ctz(new_dir);
 
         // if neighbor do not exists or is an already linked node then abort
-		if (neighbor == NULL || neighbor->parent != NULL) 
+        if (!get_neighbor(a, *x, *y, dir, &nx, &ny))
+            continue;
+        neighbor = &CELL(m, nx, ny);
+        if (*neighbor & CELL_PARENT) 
             continue;
 		
-		// make sure that neighbor node is not a wall
-		if (neighbor->type == NONE) {
+        // make sure that neighbor node is not a wall
+        if (!(*neighbor & CELL_WALL)) {
 			
-			// adopt node and remove wall between them
-			neighbor->parent = start;
-            remove_wall(m, start, neighbor);
+            // adopt node (its parent is in the opposite direction)
+            // and remove wall between them
+            *neighbor |= (((dir + 2) % 4) + 1) << PARENT_SHIFT;
+            CELL(m, *x + step_x[dir], *y + step_y[dir]) &= ~CELL_WALL;
 			
-			// return address of the child node
-			return neighbor;
-		}
-	}
+            // move onto the child node
+            *x = nx;
+            *y = ny;
+            return;
+        }
+    }
 	
-	// if neighbor can't be linked, turn backwards (return parent's address)
-	return start->parent;
+    // if neighbor can't be linked, turn backwards (move onto the parent)
+    code = (*start & CELL_PARENT) >> PARENT_SHIFT;
+    if (code != PARENT_ROOT) {
+        *x += 2 * step_x[code - 1];
+        *y += 2 * step_y[code - 1];
+    }
+}
+
+/**
+ * Explore an area with a depth-first-search that starts from its
+ * first node, the nodes of the area will form a tree
+ * 
+ * [IN]     maze*: maze structure
+ * [IN]     area*: area to be explored
+ * [IN]     rng*: random generator
+ * [OUT]    void
+ */
+static void carve(struct maze* m, struct area* a, struct rng* r) {
+    uint32_t x, y;  // node reached at each step of exploration
+
+    // start from upper right node of the area and set itself as father
+    x = a->x0 + 1;
+    y = a->y0 + 1;
+    CELL(m, x, y) |= PARENT_ROOT << PARENT_SHIFT;
+
+    // with this kind of choice, the entire area will be explored
+    do {
+        link(m, a, r, &x, &y);
+    } while (x != a->x0 + 1 || y != a->y0 + 1);
+}
+
+/**
+ * Get the area of blocks covered by a tile
+ * 
+ * [IN]     tile_job*: tiles of the maze
+ * [IN]     uint32_t: tile index
+ * [IN]     area*: area of the tile will be left here
+ * [OUT]    void
+ */
+static void tile_area(struct tile_job* job, uint32_t t, struct area* a) {
+    uint32_t tx = t / job->tiles_y;         // tile position (x position)
+    uint32_t ty = t % job->tiles_y;         // tile position (y position)
+    uint32_t rows = (job->m->height - 1) / 2;
+    uint32_t cols = (job->m->width - 1) / 2;
+
+    a->x0 = 2 * tx * job->tile;
+    a->y0 = 2 * ty * job->tile;
+    a->x1 = 2 * ((tx + 1) * job->tile < rows ? (tx + 1) * job->tile : rows) + 1;
+    a->y1 = 2 * ((ty + 1) * job->tile < cols ? (ty + 1) * job->tile : cols) + 1;
+}
+
+/**
+ * Carve tiles until all of them are taken. Each tile has its own
+ * generator, so the maze does not depend on the number of threads
+ * 
+ * [IN]     void*: the tile job
+ * [OUT]    void*: NULL
+ */
+static void* tile_worker(void* arg) {
+    struct tile_job*    job = arg;
+    struct area         a;
+    struct rng          r;
+    uint32_t            t;
+
+    while ((t = __atomic_fetch_add(&job->next, 1, __ATOMIC_RELAXED)) < job->tiles) {
+        tile_area(job, t, &a);
+        rng_seed(&r, job->seed ^ ((uint64_t)(t + 1) * 0xd1b54a32d192ed03ULL));
+        carve(job->m, &a, &r);
+    }
+
+    return NULL;
+}
+
+/**
+ * Make the node at (x, y) the root of its tree, reversing the parent
+ * directions along the path towards the old root
+ * 
+ * [IN]     maze*: maze structure
+ * [IN]     uint32_t: new root (x position)
+ * [IN]     uint32_t: new root (y position)
+ * [OUT]    void
+ */
+static void reroot(struct maze* m, uint32_t x, uint32_t y) {
+    int code;                   // parent of the current node
+    int new_code = PARENT_ROOT; // new parent of the current node
+
+    while (1) {
+        code = (CELL(m, x, y) & CELL_PARENT) >> PARENT_SHIFT;
+        CELL(m, x, y) = (CELL(m, x, y) & ~CELL_PARENT) | (new_code << PARENT_SHIFT);
+        if (code == PARENT_ROOT)
+            return;
+
+        // the old parent will point back to this node
+        new_code = ((code - 1 + 2) % 4) + 1;
+        x += 2 * step_x[code - 1];
+        y += 2 * step_y[code - 1];
+    }
+}
+
+/**
+ * Find the set that contains the set s (union-find with path halving)
+ * 
+ * [IN]     uint32_t*: father of each set
+ * [IN]     uint32_t: set to be searched
+ * [OUT]    uint32_t: representative of the set
+ */
+static uint32_t find_set(uint32_t* parent, uint32_t s) {
+    while (parent[s] != s) {
+        parent[s] = parent[parent[s]];
+        s = parent[s];
+    }
+
+    return s;
+}
+
+/**
+ * Join horizontally the nodes of a row of Eller's algorithm. Adjacent
+ * nodes of different sets are joined at random, or always in the last row
+ * 
+ * [IN]     rng*: random generator
+ * [IN]     uint32_t*: set of each node of the row
+ * [IN]     uint32_t*: father of each set
+ * [IN]     uint8_t*: blocks of the row (nodes are at odd positions)
+ * [IN]     uint32_t: number of nodes in the row
+ * [IN]     int: 1 if this is the last row
+ * [OUT]    void
+ */
+static void join_row(struct rng* r, uint32_t* sets, uint32_t* parent, uint8_t* row, 
+        uint32_t cols, int last) {
+    uint32_t c, a, b;
+
+    for (c = 0; c < cols; c++)
+        parent[c] = c;
+
+    for (c = 0; c + 1 < cols; c++) {
+        a = find_set(parent, sets[c]);
+        b = find_set(parent, sets[c + 1]);
+
+        // remove the wall between the nodes and merge the sets
+        if (a != b && (last || rng_next(r) >> 63)) {
+            parent[b] = a;
+            row[2 * c + 2] &= ~CELL_WALL;
+        }
+    }
+}
+
+/**
+ * Join vertically the nodes of a row of Eller's algorithm with the next
+ * row. Each set goes down at least once, nodes that do not go down start
+ * a new set in the next row
+ * 
+ * [IN]     rng*: random generator
+ * [IN]     uint32_t*: set of each node, replaced with the sets of the next row
+ * [IN]     uint32_t*: father of each set
+ * [IN]     uint32_t*: last node of each set (used as scratch)
+ * [IN]     uint8_t*: blocks below the row (nodes are at odd positions)
+ * [IN]     uint32_t: number of nodes in the row
+ * [OUT]    void
+ */
+static void join_down(struct rng* r, uint32_t* sets, uint32_t* parent, uint32_t* last,
+        uint8_t* row, uint32_t cols) {
+    uint32_t c, s;
+    uint32_t fresh = 0;     // next candidate for a new set
+
+    // representative and last node of each set
+    for (c = 0; c < cols; c++) {
+        sets[c] = find_set(parent, sets[c]);
+        last[sets[c]] = c;
+    }
+
+    // no set goes down yet
+    memset(parent, 0, cols * sizeof(uint32_t));
+
+    // go down at random, parent now flags the sets that went down
+    for (c = 0; c < cols; c++) {
+        if (rng_next(r) >> 63) {
+            row[2 * c + 1] &= ~CELL_WALL;
+            parent[sets[c]] = 1;
+        }
+    }
+
+    // make sure that each set goes down at least once
+    for (c = 0; c < cols; c++) {
+        s = sets[c];
+        if (!parent[s]) {
+            row[2 * last[s] + 1] &= ~CELL_WALL;
+            parent[s] = 1;
+        }
+    }
+
+    // nodes that did not go down get a set not used by the others
+    for (c = 0; c < cols; c++) {
+        if (!(row[2 * c + 1] & CELL_WALL))
+            continue;
+
+        while (parent[fresh])
+            fresh++;
+        sets[c] = fresh++;
+    }
+}
+
+/**
+ * Join the carved tiles into a single tree. The passages between tiles
+ * are chosen with Kruskal's algorithm over the tile borders (a random
+ * node pair for each border, in random order), then each tile tree is
+ * re-rooted on the node that links it to the tiles already joined
+ * 
+ * [IN]     tile_job*: tiles of the maze
+ * [IN]     uint32_t: tiles for each column of tiles
+ * [OUT]    int: -1 in case of low mem availability, 0 in case of success
+ */
+static int join_tiles(struct tile_job* job, uint32_t tiles_x) {
+    struct maze*        m = job->m;
+    struct tile_edge*   edges;          // borders between tiles
+    struct tile_edge    tmp;
+    struct area         a;
+    struct rng          r;
+    uint32_t*           sets;           // union-find over the tiles
+    uint32_t*           head;           // first passage of each tile
+    uint32_t*           next;           // next passage of the same tile
+    uint32_t*           queue;          // tiles joined, in visit order
+    uint32_t            n = 0;          // number of borders
+    uint32_t            t, e, k, h, q;
+    uint32_t            ux, uy, vx, vy;
+    int                 code;           // parent direction code
+    int                 ret = -1;
+
+    edges = malloc(2 * job->tiles * sizeof(struct tile_edge));
+    sets = malloc(job->tiles * sizeof(uint32_t));
+    head = malloc(job->tiles * sizeof(uint32_t));
+    next = malloc(4 * job->tiles * sizeof(uint32_t));
+    queue = malloc(job->tiles * sizeof(uint32_t));
+    if (edges == NULL || sets == NULL || head == NULL || next == NULL || queue == NULL)
+        goto out;
+
+    rng_seed(&r, job->seed);
+
+    // a random node pair on the border with the tile below and on the right
+    for (t = 0; t < job->tiles; t++) {
+        tile_area(job, t, &a);
+        if (t / job->tiles_y + 1 < tiles_x) {
+            edges[n].a = t;
+            edges[n].b = t + job->tiles_y;
+            edges[n].ux = a.x1 - 2;
+            edges[n].uy = a.y0 + 1 + 2 * rng_below(&r, (a.y1 - a.y0) / 2);
+            edges[n].vx = a.x1;
+            edges[n].vy = edges[n].uy;
+            n++;
+        }
+        if (t % job->tiles_y + 1 < job->tiles_y) {
+            edges[n].a = t;
+            edges[n].b = t + 1;
+            edges[n].ux = a.x0 + 1 + 2 * rng_below(&r, (a.x1 - a.x0) / 2);
+            edges[n].uy = a.y1 - 2;
+            edges[n].vx = edges[n].ux;
+            edges[n].vy = a.y1;
+            n++;
+        }
+    }
+
+    // random order of the borders (Fisher-Yates)
+    for (e = n; e > 1; e--) {
+        k = rng_below(&r, e);
+        tmp = edges[e - 1];
+        edges[e - 1] = edges[k];
+        edges[k] = tmp;
+    }
+
+    // keep the borders that join different sets of tiles
+    for (t = 0; t < job->tiles; t++) {
+        sets[t] = t;
+        head[t] = UINT32_MAX;
+    }
+    for (e = 0; e < n; e++) {
+        ux = find_set(sets, edges[e].a);
+        vx = find_set(sets, edges[e].b);
+        if (ux == vx)
+            continue;
+
+        sets[vx] = ux;
+        CELL(m, (edges[e].ux + edges[e].vx) / 2, (edges[e].uy + edges[e].vy) / 2) &= ~CELL_WALL;
+
+        // remember the passage for both tiles
+        next[2 * e] = head[edges[e].a];
+        head[edges[e].a] = 2 * e;
+        next[2 * e + 1] = head[edges[e].b];
+        head[edges[e].b] = 2 * e + 1;
+    }
+
+    // visit the tiles from the first one, hanging each tile on the previous
+    for (t = 0; t < job->tiles; t++)
+        sets[t] = 0;
+    queue[0] = 0;
+    sets[0] = 1;
+    for (h = 0, q = 1; h < q; h++) {
+        for (k = head[queue[h]]; k != UINT32_MAX; k = next[k]) {
+            e = k / 2;
+            t = (k % 2) ? edges[e].a : edges[e].b;
+            if (sets[t])
+                continue;
+
+            // node of the new tile and node of the tile already joined
+            if (k % 2) {
+                ux = edges[e].vx; uy = edges[e].vy;
+                vx = edges[e].ux; vy = edges[e].uy;
+            } else {
+                ux = edges[e].ux; uy = edges[e].uy;
+                vx = edges[e].vx; vy = edges[e].vy;
+            }
+
+            // the parent of the new tile root is on the other side
+            reroot(m, vx, vy);
+            if (ux > vx)
+                code = 1;
+            else if (uy > vy)
+                code = 2;
+            else if (ux < vx)
+                code = 3;
+            else
+                code = 4;
+            CELL(m, vx, vy) = (CELL(m, vx, vy) & ~CELL_PARENT) | (code << PARENT_SHIFT);
+
+            sets[t] = 1;
+            queue[q++] = t;
+        }
+    }
+
+    ret = 0;
+out:
+    free(edges);
+    free(sets);
+    free(head);
+    free(next);
+    free(queue);
+    return ret;
+}
+
+/**
+ * Check if a block is a wall not yet covered by a rectangle
+ * 
+ * [IN]     maze*: maze structure
+ * [IN]     uint64_t*: covered flags, one bit for each block of the maze
+ * [IN]     uint32_t: block position in the maze (x position)
+ * [IN]     uint32_t: block position in the maze (y position)
+ * [OUT]    int: 1 if the block can be merged, 0 otherwise
+ */
+static int is_free_wall(struct maze* m, uint64_t* covered, uint32_t x, uint32_t y) {
+    size_t i = (size_t)x * m->width + y;
+
+    return (m->cells[i] & CELL_WALL) && !(covered[i / 64] >> (i % 64) & 1);
+}
+
+/**
+ * Check if a run of blocks along y is entirely made of free walls
+ * 
+ * [IN]     maze*: maze structure
+ * [IN]     uint64_t*: covered flags, one bit for each block of the maze
+ * [IN]     uint32_t: first block of the run (x position)
+ * [IN]     uint32_t: first block of the run (y position)
+ * [IN]     uint32_t: run length
+ * [OUT]    int: 1 if the whole run can be merged, 0 otherwise
+ */
+static int is_free_row(struct maze* m, uint64_t* covered, uint32_t x, uint32_t y, uint32_t len) {
+    uint32_t k;
+
+    for (k = 0; k < len; k++)
+        if (!is_free_wall(m, covered, x, y + k))
+            return 0;
+
+    return 1;
+}
+
+/**
+ * Check if a run of blocks along x is entirely made of free walls
+ * 
+ * [IN]     maze*: maze structure
+ * [IN]     uint64_t*: covered flags, one bit for each block of the maze
+ * [IN]     uint32_t: first block of the run (x position)
+ * [IN]     uint32_t: first block of the run (y position)
+ * [IN]     uint32_t: run length
+ * [OUT]    int: 1 if the whole run can be merged, 0 otherwise
+ */
+static int is_free_column(struct maze* m, uint64_t* covered, uint32_t x, uint32_t y, uint32_t len) {
+    uint32_t k;
+
+    for (k = 0; k < len; k++)
+        if (!is_free_wall(m, covered, x + k, y))
+            return 0;
+
+    return 1;
 }
 
 // -----------------------------------------------------
@@ -139,82 +559,295 @@ static struct node* link(struct maze* m, struct node* start) {
  * Init the maze 
  * 
  * [IN]     maze*: pointer to the graph to be initialized as maze
- * [IN]     uint8_t: maze width (number of block)
- * [IN]     uint8_t: maze height (number of block)
+ * [IN]     uint32_t: maze width (number of block)
+ * [IN]     uint32_t: maze height (number of block)
  * [OUT]    int: -1 in case of low mem availability, 0 in case of success
  */
-int init_maze(struct maze* m, uint8_t width, uint8_t height) {
-	int             i, j;       // iterate over the graph
-    struct node*    n;          // temp pointer to nodes
+int init_maze(struct maze* m, uint32_t width, uint32_t height) {
+    uint32_t    i, j;       // iterate over the graph
 	
-	// allocate memory for graph
-	m->graph = calloc(width * height, sizeof(struct node));
+    // allocate memory for graph, one byte for each block
+    m->cells = malloc((size_t)width * height);
 	
-	// out of memory
-    if (m->graph == NULL) 
+    // out of memory
+    if (m->cells == NULL) 
         return -1;
 		
     // fill up remaining info
     m->width = width;
     m->height = height;
 
-	// setup whole graph
-	for (i = 0; i < height; i++) {
-		for (j = 0; j < width; j++) {
+    // setup the first two rows: odd blocks of odd rows are nodes,
+    // everything else is a wall
+    for (j = 0; j < width; j++) {
+        m->cells[j] = CELL_WALL;
+        if (height > 1)
+            m->cells[width + j] = (j % 2) ? ANY_DIR : CELL_WALL;
+    }
 
-            // iterate over graph
-            n = m->graph + (i * width) + j;            
+    // the other rows are copies of the first two
+    for (i = 2; i < height; i++)
+        memcpy(&CELL(m, i, 0), &CELL(m, i % 2, 0), width);
 
-			if (i*j % 2)
-                init_node(n, i, j, ANY_DIR, NONE);
-			else
-                init_node(n, i, j, NO_DIR, WALL);
-        }
-    }
+    return 0;
+}
 
-	return 0;
+/**
+ * Free the memory allocated for the maze
+ * 
+ * [IN]     maze*: pointer to the maze struct
+ * [OUT]    void
+ */
+void free_maze(struct maze* m) {
+    free(m->cells);
+    m->cells = NULL;
 }
 
 /**
  * Explore the graph in order to create the maze
  * 
  * [IN]     maze*: pointer to the maze struct
+ * [IN]     uint64_t: seed of the random generator
  * [OUT]    void
  */
-void create_maze(struct maze* m) {
-    struct node* start;    // node from which begin to explore graph
-    struct node* neighbor; // node reached at each step of exploration
+void create_maze(struct maze* m, uint64_t seed) {
+    struct area a = {0, 0, m->height, m->width};    // the whole maze
+    struct rng  r;                                  // random generator of this maze
 
-    // start from upper right node of graph and set itself as father
-	start = m->graph + m->width + 1; 
-	start->parent = start;
+    // the maze has no node to explore
+    if (m->width < 3 || m->height < 3)
+        return;
 
-    // with this kind of choice, the entire maze will be explored
-	neighbor = start;
+    // initialize random generator
+    rng_seed(&r, seed);
 
-    // initialize random seed
-    srand(time(NULL));
+    carve(m, &a, &r);
+}
 
-    do {
-        neighbor = link(m, neighbor);
-    } while(neighbor != start);
+/**
+ * Explore the graph in order to create the maze using more threads.
+ * The maze is split into square tiles that are carved independently,
+ * then the tiles are joined into a single tree. The maze depends on
+ * the seed and on the tile size, not on the number of threads
+ * 
+ * [IN]     maze*: pointer to the maze struct
+ * [IN]     uint64_t: seed of the random generator (same seed, same maze)
+ * [IN]     uint32_t: nodes for each side of a tile (at least 1)
+ * [IN]     int: number of threads
+ * [OUT]    int: -1 in case of low mem availability, 0 in case of success
+ */
+int create_maze_tiled(struct maze* m, uint64_t seed, uint32_t tile, int threads) {
+    struct tile_job job;        // tiles shared by the threads
+    pthread_t*      workers;    // threads other than this one
+    uint32_t        tiles_x;    // tiles for each column of tiles
+    int             i, started;
+
+    // the maze has no node to explore
+    if (m->width < 3 || m->height < 3)
+        return 0;
+
+    if (tile == 0)
+        tile = 1;
+
+    job.m = m;
+    job.seed = seed;
+    job.tile = tile;
+    job.tiles_y = ((m->width - 1) / 2 + tile - 1) / tile;
+    tiles_x = ((m->height - 1) / 2 + tile - 1) / tile;
+    job.tiles = tiles_x * job.tiles_y;
+    job.next = 0;
+
+    // this thread works too, if a thread can't start the others do its work
+    workers = malloc((threads > 1 ? threads - 1 : 1) * sizeof(pthread_t));
+    if (workers == NULL)
+        return -1;
+    for (started = 0; started < threads - 1; started++)
+        if (pthread_create(workers + started, NULL, tile_worker, &job) != 0)
+            break;
+    tile_worker(&job);
+    for (i = 0; i < started; i++)
+        pthread_join(workers[i], NULL);
+    free(workers);
+
+    return join_tiles(&job, tiles_x);
+}
+
+/**
+ * Generate a maze row by row with Eller's algorithm, without storing
+ * it. Only the sets of the current row are kept in memory, so that
+ * memory is O(width) for any height. Each finished row is passed to
+ * the callback, from the first to the last one
+ * 
+ * [IN]     uint32_t: maze width (number of block)
+ * [IN]     uint32_t: maze height (number of block)
+ * [IN]     uint64_t: seed of the random generator (same seed, same maze)
+ * [IN]     row_callback: function called for each row
+ * [IN]     void*: user data passed to the callback
+ * [OUT]    int: -1 in case of low mem availability, 0 in case of success
+ */
+int stream_maze(uint32_t width, uint32_t height, uint64_t seed, row_callback cb, void* data) {
+    uint32_t    cols = (width - 1) / 2;     // nodes in a row
+    uint32_t    rows = (height - 1) / 2;    // rows of nodes
+    uint32_t    i, c;                       // iterate over the rows and nodes
+    uint32_t*   sets;                       // set of each node of the row
+    uint32_t*   parent;                     // father of each set
+    uint32_t*   last;                       // last node of each set
+    uint8_t*    row;                        // blocks of the row
+    struct rng  r;                          // random generator of this maze
+
+    sets = malloc(cols * sizeof(uint32_t));
+    parent = malloc(cols * sizeof(uint32_t));
+    last = malloc(cols * sizeof(uint32_t));
+    row = malloc(width);
+
+    // out of memory
+    if ((cols && (sets == NULL || parent == NULL || last == NULL)) || row == NULL) {
+        free(sets);
+        free(parent);
+        free(last);
+        free(row);
+        return -1;
+    }
+
+    rng_seed(&r, seed);
+
+    // first row is a wall, then each node starts in its own set
+    memset(row, CELL_WALL, width);
+    cb(data, 0, row, width);
+    for (c = 0; c < cols; c++)
+        sets[c] = c;
+
+    for (i = 0; i < rows; i++) {
+        // row of nodes and horizontal passages
+        memset(row, CELL_WALL, width);
+        for (c = 0; c < cols; c++)
+            row[2 * c + 1] = NO_DIR;
+        join_row(&r, sets, parent, row, cols, i + 1 == rows);
+        cb(data, 2 * i + 1, row, width);
+
+        // row of vertical passages towards the next row of nodes
+        if (i + 1 < rows) {
+            memset(row, CELL_WALL, width);
+            join_down(&r, sets, parent, last, row, cols);
+            cb(data, 2 * i + 2, row, width);
+        }
+    }
+
+    // last rows are walls
+    for (i = rows ? 2 * rows : 1; i < height; i++) {
+        memset(row, CELL_WALL, width);
+        cb(data, i, row, width);
+    }
+
+    free(sets);
+    free(parent);
+    free(last);
+    free(row);
+    return 0;
 }
 
 /**
- * Draw into the terminal screen a visual representation of the maze
+ * Get the type of block at position (x, y)
  * 
  * [IN]     maze*: pointer to the maze struct
+ * [IN]     uint32_t: block position in the maze (x position)
+ * [IN]     uint32_t: block position in the maze (y position)
+ * [OUT]    block: type of the block
+ */
+enum block get_block(struct maze* m, uint32_t x, uint32_t y) {
+    return (CELL(m, x, y) & CELL_WALL) ? WALL : NONE;
+}
+
+/**
+ * Set the type of block at position (x, y)
+ * 
+ * [IN]     maze*: pointer to the maze struct
+ * [IN]     uint32_t: block position in the maze (x position)
+ * [IN]     uint32_t: block position in the maze (y position)
+ * [IN]     block: new type of the block
  * [OUT]    void
  */
-void draw_maze(struct maze* m) {
-	int i, j;   // iterate over the graph
+void set_block(struct maze* m, uint32_t x, uint32_t y, enum block type) {
+    if (type == WALL)
+        CELL(m, x, y) |= CELL_WALL;
+    else
+        CELL(m, x, y) &= ~CELL_WALL;
+}
+
+/**
+ * Cover all the wall blocks of the maze with the smallest set of rectangles
+ * that the greedy strategy can find. Each wall block is covered exactly once.
+ * The returned array must be freed by the caller.
+ * 
+ * [IN]     maze*: pointer to the maze struct
+ * [IN]     wall_box**: the array of rectangles will be left here
+ * [OUT]    long: number of rectangles, -1 in case of low mem availability
+ */
+long merge_walls(struct maze* m, struct wall_box** boxes) {
+    uint32_t            i, j, k, l; // iterate over the graph
+    uint32_t            dx, dy;     // extent of the current rectangle
+    size_t              b;          // bit of the covered block
+    long                n, size;    // rectangles found and array capacity
+    uint64_t*           covered;    // blocks already part of a rectangle
+    struct wall_box*    tmp;        // used to grow the array
 
-	for (i = 0; i < m->height; i++) {
-		for (j = 0; j < m->width; j++)
-            if(m->graph[i * m->width + j].type == WALL)
-			    printf("%s", "█");
-            else
-                printf("%s", " ");
-		printf("\n");
+    covered = calloc(((size_t)m->width * m->height + 63) / 64, sizeof(uint64_t));
+    size = 16;
+    n = 0;
+    *boxes = malloc(size * sizeof(struct wall_box));
+
+    // out of memory
+    if (covered == NULL || *boxes == NULL) {
+        free(covered);
+        free(*boxes);
+        return -1;
     }
-}
\ No newline at end of file
+
+    for (i = 0; i < m->height; i++) {
+        for (j = 0; j < m->width; j++) {
+            if (!is_free_wall(m, covered, i, j))
+                continue;
+
+            // measure the runs starting from this block in both directions
+            for (dy = 1; j + dy < m->width && is_free_wall(m, covered, i, j + dy); dy++);
+            for (dx = 1; i + dx < m->height && is_free_wall(m, covered, i + dx, j); dx++);
+
+            // keep the longest run and grow it into a rectangle
+            if (dy >= dx) {
+                for (dx = 1; i + dx < m->height && is_free_row(m, covered, i + dx, j, dy); dx++);
+            } else {
+                for (dy = 1; j + dy < m->width && is_free_column(m, covered, i, j + dy, dx); dy++);
+            }
+
+            // mark blocks as covered
+            for (k = 0; k < dx; k++) {
+                b = (size_t)(i + k) * m->width + j;
+                for (l = 0; l < dy; l++, b++)
+                    covered[b / 64] |= (uint64_t)1 << (b % 64);
+            }
+
+            // make room for the new rectangle
+            if (n == size) {
+                size *= 2;
+                tmp = realloc(*boxes, size * sizeof(struct wall_box));
+
+                if (tmp == NULL) {
+                    free(covered);
+                    free(*boxes);
+                    return -1;
+                }
+
+                *boxes = tmp;
+            }
+
+            (*boxes)[n].x = i;
+            (*boxes)[n].y = j;
+            (*boxes)[n].dx = dx;
+            (*boxes)[n].dy = dy;
+            n++;
+        }
+    }
+
+    free(covered);
+    return n;
+}
@@ -34,6 +34,7 @@
 #define MAZE_H
 
 #include <stdint.h>
+#include <stddef.h>
 
 # define RIGHT_DIR  0b00000001
 # define DOWN_DIR   0b00000010
@@ -42,6 +43,27 @@
 # define ANY_DIR    0b00001111
 # define NO_DIR     0b00000000  
 
+// ----------------------------
+// CELL LAYOUT
+// ---------------------------.
+
+# define CELL_DIRS      0b00001111  // directions to be explored
+# define CELL_PARENT    0b01110000  // direction code of the parent
+# define CELL_WALL      0b10000000  // the cell is a wall
+# define PARENT_SHIFT   4
+
+# define PARENT_NONE    0           // the node has no parent (not linked)
+# define PARENT_ROOT    5           // the node is the root of the graph
+                                    // 1..4: parent is 2 blocks away towards
+                                    // the direction (1 << (code - 1))
+
+# define TILE_NODES     256         // default tile side of the parallel generator
+
+/**
+ * Cell of the maze at position (x, y)
+ */
+# define CELL(m, x, y)  ((m)->cells[(size_t)(x) * (m)->width + (y)])
+
 /**
  * ENUM BLOCK
  * Possible type of a cell of graph
@@ -52,53 +74,128 @@ enum block {
 };
 
 /**
- * STRUCT NODE
- * Contains info for each node of the graph
+ * STRUCT MAZE
+ * Contains the entire graph and maze bounds. Each cell is a single
+ * byte that packs the block type, the directions still to be explored
+ * and the direction of the parent node
  */
-struct node {
-    struct node*    parent; // a pointer to parent node (if one)
-    uint8_t         x;      // x position of the graph-node in the maze
-    uint8_t         y;      // y position of the graph-node in the maze
-    uint8_t         dirs;   // directions to be explored
-    enum block      type;   // type of block to be drawn
-    void*           info;   // optional linkable info
+struct maze {
+    uint8_t*        cells;  // cells of the graph, row by row
+    uint32_t        width;  // maze width (number of block)
+    uint32_t        height; // maze height (number of block)
 };
 
 /**
- * STRUCT MAZE
- * Contains the entire graph and maze bounds
+ * STRUCT WALL_BOX
+ * A rectangle of adjacent wall blocks that can be emitted as a single box
  */
-struct maze {
-    struct node*    graph;  // root of the graph
-    uint8_t         width;  // maze width (number of block)
-    uint8_t         height; // maze height (number of block)
+struct wall_box {
+    uint32_t        x;      // x position of the first block of the rectangle
+    uint32_t        y;      // y position of the first block of the rectangle
+    uint32_t        dx;     // number of blocks covered along x
+    uint32_t        dy;     // number of blocks covered along y
 };
 
+/**
+ * ROW_CALLBACK
+ * Receive a finished row of blocks from the streaming generator.
+ * Walls have CELL_WALL set. The row can be modified, it is
+ * overwritten after the callback returns
+ * 
+ * [IN]     void*: user data
+ * [IN]     uint32_t: row position in the maze (x position)
+ * [IN]     uint8_t*: blocks of the row
+ * [IN]     uint32_t: number of blocks in the row (maze width)
+ */
+typedef void (*row_callback)(void* data, uint32_t x, uint8_t* row, uint32_t width);
+
 /**
  * Init the maze 
  * 
  * [IN]     maze*: pointer to the maze struct to be initialized
- * [IN]     uint8_t: maze width (number of block)
- * [IN]     uint8_t: maze height (number of block)
+ * [IN]     uint32_t: maze width (number of block)
+ * [IN]     uint32_t: maze height (number of block)
  * [OUT]    int: -1 in case of low mem availability, 0 in case of success
  */
-int init_maze(struct maze* m, uint8_t width, uint8_t height);
+int init_maze(struct maze* m, uint32_t width, uint32_t height);
+
+/**
+ * Free the memory allocated for the maze
+ * 
+ * [IN]     maze*: pointer to the maze struct
+ * [OUT]    void
+ */
+void free_maze(struct maze* m);
 
 /**
  * Explore the graph in order to create the maze
  * 
  * [IN]     maze*: pointer to the maze struct
+ * [IN]     uint64_t: seed of the random generator (same seed, same maze)
  * [OUT]    void
  */
-void create_maze(struct maze* m);
+void create_maze(struct maze* m, uint64_t seed);
 
 /**
- * Draw into the terminal screen a visual representation of the maze
+ * Explore the graph in order to create the maze using more threads.
+ * The maze is split into square tiles that are carved independently,
+ * then the tiles are joined into a single tree. The maze depends on
+ * the seed and on the tile size, not on the number of threads
  * 
  * [IN]     maze*: pointer to the maze struct
+ * [IN]     uint64_t: seed of the random generator (same seed, same maze)
+ * [IN]     uint32_t: nodes for each side of a tile (at least 1)
+ * [IN]     int: number of threads
+ * [OUT]    int: -1 in case of low mem availability, 0 in case of success
+ */
+int create_maze_tiled(struct maze* m, uint64_t seed, uint32_t tile, int threads);
+
+/**
+ * Generate a maze row by row with Eller's algorithm, without storing
+ * it. Only the sets of the current row are kept in memory, so that
+ * memory is O(width) for any height. Each finished row is passed to
+ * the callback, from the first to the last one
+ * 
+ * [IN]     uint32_t: maze width (number of block)
+ * [IN]     uint32_t: maze height (number of block)
+ * [IN]     uint64_t: seed of the random generator (same seed, same maze)
+ * [IN]     row_callback: function called for each row
+ * [IN]     void*: user data passed to the callback
+ * [OUT]    int: -1 in case of low mem availability, 0 in case of success
+ */
+int stream_maze(uint32_t width, uint32_t height, uint64_t seed, row_callback cb, void* data);
+
+/**
+ * Get the type of block at position (x, y)
+ * 
+ * [IN]     maze*: pointer to the maze struct
+ * [IN]     uint32_t: block position in the maze (x position)
+ * [IN]     uint32_t: block position in the maze (y position)
+ * [OUT]    block: type of the block
+ */
+enum block get_block(struct maze* m, uint32_t x, uint32_t y);
+
+/**
+ * Set the type of block at position (x, y)
+ * 
+ * [IN]     maze*: pointer to the maze struct
+ * [IN]     uint32_t: block position in the maze (x position)
+ * [IN]     uint32_t: block position in the maze (y position)
+ * [IN]     block: new type of the block
  * [OUT]    void
  */
-void draw_maze(struct maze* m);
+void set_block(struct maze* m, uint32_t x, uint32_t y, enum block type);
+
+/**
+ * Cover all the wall blocks of the maze with the smallest set of rectangles
+ * that the greedy strategy can find. Each wall block is covered exactly once.
+ * The returned array must be freed by the caller.
+ * 
+ * [IN]     maze*: pointer to the maze struct
+ * [IN]     wall_box**: the array of rectangles will be left here
+ * [OUT]    long: number of rectangles, -1 in case of low mem availability
+ */
+long merge_walls(struct maze* m, struct wall_box** boxes);
 
 
 #endif
\ No newline at end of file
@@ -0,0 +1,270 @@
+/**
+ * MAZEFILE
+ * Versioned binary file of a maze (bit-packed walls and parent
+ * directions) that is written and read through mmap
+ */
+
+#include "mazefile.h"
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// -----------------------------------------------------
+// PRIVATE METHOD
+// -----------------------------------------------------
+
+/**
+ * Compute where walls and parents are and how big the file is
+ *
+ * [IN]     maze_header*: header with size and flags already set
+ * [OUT]    size_t: bytes of the file
+ */
+static size_t layout(struct maze_header* h) {
+    size_t stride = ((size_t)h->width + 63) / 64;
+    size_t nodes = (size_t)(h->width ? (h->width - 1) / 2 : 0) *
+            (h->height ? (h->height - 1) / 2 : 0);
+    size_t size;
+
+    h->walls = sizeof(struct maze_header);
+    size = h->walls + stride * h->height * sizeof(uint64_t);
+
+    h->parents = 0;
+    if (h->flags & MAZE_FILE_PARENTS) {
+        h->parents = size;
+        size += (nodes + 1) / 2;
+    }
+
+    return size;
+}
+
+/**
+ * Find walls and parents inside the mapping
+ *
+ * [IN]     maze_file*: pointer to the maze file
+ * [OUT]    void
+ */
+static void locate(struct maze_file* f) {
+    uint8_t* base = (uint8_t*)f->header;
+
+    f->stride = ((size_t)f->header->width + 63) / 64;
+    f->walls = (uint64_t*)(base + f->header->walls);
+    f->parents = f->header->parents ? base + f->header->parents : NULL;
+}
+
+// -----------------------------------------------------
+// PUBLIC METHOD
+// -----------------------------------------------------
+
+/**
+ * Create a maze file and map it for writing. Rows are then written from
+ * the first to the last one with write_maze_row
+ *
+ * [IN]     maze_file*: pointer to the maze file
+ * [IN]     char*: file name
+ * [IN]     uint32_t: maze width (number of block)
+ * [IN]     uint32_t: maze height (number of block)
+ * [IN]     uint64_t: seed of the maze
+ * [IN]     double: side of a block in meters
+ * [IN]     uint32_t: MAZE_FILE_PARENTS to store the parents too, 0 otherwise
+ * [OUT]    int: -1 in case of error, 0 in case of success
+ */
+int create_maze_file(struct maze_file* f, char* filename, uint32_t width, uint32_t height,
+        uint64_t seed, double box_dim, uint32_t flags) {
+    struct maze_header  h;
+
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, MAZE_FILE_MAGIC, sizeof(MAZE_FILE_MAGIC));
+    h.version = MAZE_FILE_VERSION;
+    h.flags = flags & MAZE_FILE_PARENTS;
+    h.width = width;
+    h.height = height;
+    h.seed = seed;
+    h.box_dim = box_dim;
+    f->size = layout(&h);
+
+    // the file is sized first, then the whole file is mapped (it starts
+    // all zero: no walls and no parents)
+    f->fd = open(filename, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (f->fd < 0)
+        return -1;
+    if (ftruncate(f->fd, f->size)) {
+        close(f->fd);
+        return -1;
+    }
+
+    f->header = mmap(NULL, f->size, PROT_READ | PROT_WRITE, MAP_SHARED, f->fd, 0);
+    if (f->header == MAP_FAILED) {
+        close(f->fd);
+        return -1;
+    }
+
+    *f->header = h;
+    locate(f);
+    return 0;
+}
+
+/**
+ * Write a row of blocks into a maze file. The signature matches
+ * row_callback, so that rows can be written while they are streamed
+ *
+ * [IN]     void*: pointer to the maze file
+ * [IN]     uint32_t: row position in the maze (x position)
+ * [IN]     uint8_t*: blocks of the row
+ * [IN]     uint32_t: number of blocks in the row
+ * [OUT]    void
+ */
+void write_maze_row(void* data, uint32_t x, uint8_t* row, uint32_t width) {
+    struct maze_file*   f = data;
+    uint64_t*           words = f->walls + x * f->stride;
+    uint64_t            w;
+    size_t              node;
+    uint32_t            j, k;
+    uint8_t             code;
+
+    // 64 blocks for each word
+    for (j = 0; j < width; j += 64) {
+        w = 0;
+        for (k = 0; k < 64 && j + k < width; k++)
+            w |= (uint64_t)(row[j + k] >> 7) << k;
+        words[j / 64] = w;
+    }
+
+    // nodes are on odd rows and odd columns
+    if (f->parents == NULL || x % 2 == 0 || x + 1 >= f->header->height)
+        return;
+    node = (size_t)(x / 2) * ((width - 1) / 2);
+    for (j = 1; j + 1 < width; j += 2, node++) {
+        code = (row[j] & CELL_PARENT) >> PARENT_SHIFT;
+        f->parents[node / 2] &= node % 2 ? 0x0f : 0xf0;
+        f->parents[node / 2] |= node % 2 ? code << 4 : code;
+    }
+}
+
+/**
+ * Map an existing maze file for reading and check its header
+ *
+ * [IN]     maze_file*: pointer to the maze file
+ * [IN]     char*: file name
+ * [OUT]    int: -1 if the file can't be read or is not a valid maze
+ *               file, 0 in case of success
+ */
+int open_maze_file(struct maze_file* f, char* filename) {
+    struct maze_header  h;
+    struct stat         st;
+
+    f->fd = open(filename, O_RDONLY);
+    if (f->fd < 0)
+        return -1;
+    if (fstat(f->fd, &st) || (size_t)st.st_size < sizeof(struct maze_header)) {
+        close(f->fd);
+        return -1;
+    }
+    f->size = st.st_size;
+
+    f->header = mmap(NULL, f->size, PROT_READ, MAP_SHARED, f->fd, 0);
+    if (f->header == MAP_FAILED) {
+        close(f->fd);
+        return -1;
+    }
+
+    // the layout must be the one this version would write
+    h = *f->header;
+    if (memcmp(h.magic, MAZE_FILE_MAGIC, sizeof(MAZE_FILE_MAGIC)) ||
+            h.version != MAZE_FILE_VERSION || h.flags & ~MAZE_FILE_PARENTS ||
+            layout(&h) > f->size || h.walls != f->header->walls ||
+            h.parents != f->header->parents) {
+        close_maze_file(f);
+        return -1;
+    }
+
+    locate(f);
+    return 0;
+}
+
+/**
+ * Unmap and close a maze file
+ *
+ * [IN]     maze_file*: pointer to the maze file
+ * [OUT]    int: -1 in case of error, 0 in case of success
+ */
+int close_maze_file(struct maze_file* f) {
+    int ret = 0;
+
+    if (munmap(f->header, f->size))
+        ret = -1;
+    if (close(f->fd))
+        ret = -1;
+
+    f->header = NULL;
+    f->walls = NULL;
+    f->parents = NULL;
+    return ret;
+}
+
+/**
+ * Get the type of block at position (x, y) directly from the file
+ *
+ * [IN]     maze_file*: pointer to the maze file
+ * [IN]     uint32_t: block position in the maze (x position)
+ * [IN]     uint32_t: block position in the maze (y position)
+ * [OUT]    block: type of the block
+ */
+enum block get_file_block(struct maze_file* f, uint32_t x, uint32_t y) {
+    return (f->walls[x * f->stride + y / 64] >> (y % 64)) & 1 ? WALL : NONE;
+}
+
+/**
+ * Save a maze into a file, parents included
+ *
+ * [IN]     maze*: pointer to the maze struct
+ * [IN]     char*: file name
+ * [IN]     uint64_t: seed of the maze
+ * [IN]     double: side of a block in meters
+ * [OUT]    int: -1 in case of error, 0 in case of success
+ */
+int save_maze(struct maze* m, char* filename, uint64_t seed, double box_dim) {
+    struct maze_file    f;
+    uint32_t            i;
+
+    if (create_maze_file(&f, filename, m->width, m->height, seed, box_dim, MAZE_FILE_PARENTS))
+        return -1;
+
+    for (i = 0; i < m->height; i++)
+        write_maze_row(&f, i, &CELL(m, i, 0), m->width);
+
+    return close_maze_file(&f);
+}
+
+/**
+ * Load a maze from an open maze file
+ *
+ * [IN]     maze_file*: pointer to the maze file
+ * [IN]     maze*: pointer to the maze struct to be initialized
+ * [OUT]    int: -1 in case of low mem availability, 0 in case of success
+ */
+int load_maze(struct maze_file* f, struct maze* m) {
+    uint32_t    i, j;
+    uint64_t*   words;
+    size_t      node;
+
+    if (init_maze(m, f->header->width, f->header->height))
+        return -1;
+
+    for (i = 0; i < m->height; i++) {
+        words = f->walls + i * f->stride;
+        for (j = 0; j < m->width; j++)
+            CELL(m, i, j) = (words[j / 64] >> (j % 64) & 1) ? CELL_WALL : 0;
+
+        // parents of the nodes of the row
+        if (f->parents == NULL || i % 2 == 0 || i + 1 >= m->height)
+            continue;
+        node = (size_t)(i / 2) * ((m->width - 1) / 2);
+        for (j = 1; j + 1 < m->width; j += 2, node++)
+            CELL(m, i, j) |= (f->parents[node / 2] >> (node % 2 * 4) & 0x0f) << PARENT_SHIFT;
+    }
+
+    return 0;
+}
@@ -0,0 +1,153 @@
+/**
+ * MAZEFILE
+ * Versioned binary file of a maze (bit-packed walls and parent
+ * directions) that is written and read through mmap
+ *
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2018, Gabriele Ara, Gabriele Serra
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef MAZEFILE_H
+#define MAZEFILE_H
+
+#include "maze.h"
+
+# define MAZE_FILE_MAGIC    "MAZEGEN"   // first bytes of a maze file
+# define MAZE_FILE_VERSION  1
+# define MAZE_FILE_PARENTS  0b00000001  // the file contains the parent directions
+
+/**
+ * STRUCT MAZE_HEADER
+ * First 64 bytes of a maze file, in the byte order of the machine that
+ * wrote it. The walls follow the header, row by row: a bit for each
+ * block (1 for walls), each row padded to 64 bits. The parent direction
+ * codes of the nodes (odd x and y) follow the walls, 4 bits each, node
+ * by node, the first one in the low bits of a byte
+ */
+struct maze_header {
+    char            magic[8];   // MAZE_FILE_MAGIC
+    uint32_t        version;    // MAZE_FILE_VERSION
+    uint32_t        flags;      // MAZE_FILE_PARENTS if parents are present
+    uint32_t        width;      // maze width (number of block)
+    uint32_t        height;     // maze height (number of block)
+    uint64_t        seed;       // seed of the maze
+    double          box_dim;    // side of a block in meters
+    uint64_t        walls;      // offset of the walls
+    uint64_t        parents;    // offset of the parents, 0 if not present
+    uint64_t        reserved;   // always 0
+};
+
+/**
+ * STRUCT MAZE_FILE
+ * A maze file mapped into memory
+ */
+struct maze_file {
+    int                     fd;         // file descriptor
+    size_t                  size;       // bytes of the file
+    struct maze_header*     header;     // the mapping, it starts with the header
+    uint64_t*               walls;      // wall bits
+    uint8_t*                parents;    // parent codes, NULL if not present
+    size_t                  stride;     // words of each row of walls
+};
+
+/**
+ * Create a maze file and map it for writing. Rows are then written from
+ * the first to the last one with write_maze_row
+ * 
+ * [IN]     maze_file*: pointer to the maze file
+ * [IN]     char*: file name
+ * [IN]     uint32_t: maze width (number of block)
+ * [IN]     uint32_t: maze height (number of block)
+ * [IN]     uint64_t: seed of the maze
+ * [IN]     double: side of a block in meters
+ * [IN]     uint32_t: MAZE_FILE_PARENTS to store the parents too, 0 otherwise
+ * [OUT]    int: -1 in case of error, 0 in case of success
+ */
+int create_maze_file(struct maze_file* f, char* filename, uint32_t width, uint32_t height,
+        uint64_t seed, double box_dim, uint32_t flags);
+
+/**
+ * Write a row of blocks into a maze file. The signature matches
+ * row_callback, so that rows can be written while they are streamed
+ * 
+ * [IN]     void*: pointer to the maze file
+ * [IN]     uint32_t: row position in the maze (x position)
+ * [IN]     uint8_t*: blocks of the row
+ * [IN]     uint32_t: number of blocks in the row
+ * [OUT]    void
+ */
+void write_maze_row(void* data, uint32_t x, uint8_t* row, uint32_t width);
+
+/**
+ * Map an existing maze file for reading and check its header
+ * 
+ * [IN]     maze_file*: pointer to the maze file
+ * [IN]     char*: file name
+ * [OUT]    int: -1 if the file can't be read or is not a valid maze
+ *               file, 0 in case of success
+ */
+int open_maze_file(struct maze_file* f, char* filename);
+
+/**
+ * Unmap and close a maze file
+ * 
+ * [IN]     maze_file*: pointer to the maze file
+ * [OUT]    int: -1 in case of error, 0 in case of success
+ */
+int close_maze_file(struct maze_file* f);
+
+/**
+ * Get the type of block at position (x, y) directly from the file
+ * 
+ * [IN]     maze_file*: pointer to the maze file
+ * [IN]     uint32_t: block position in the maze (x position)
+ * [IN]     uint32_t: block position in the maze (y position)
+ * [OUT]    block: type of the block
+ */
+enum block get_file_block(struct maze_file* f, uint32_t x, uint32_t y);
+
+/**
+ * Save a maze into a file, parents included
+ * 
+ * [IN]     maze*: pointer to the maze struct
+ * [IN]     char*: file name
+ * [IN]     uint64_t: seed of the maze
+ * [IN]     double: side of a block in meters
+ * [OUT]    int: -1 in case of error, 0 in case of success
+ */
+int save_maze(struct maze* m, char* filename, uint64_t seed, double box_dim);
+
+/**
+ * Load a maze from an open maze file
+ * 
+ * [IN]     maze_file*: pointer to the maze file
+ * [IN]     maze*: pointer to the maze struct to be initialized
+ * [OUT]    int: -1 in case of low mem availability, 0 in case of success
+ */
+int load_maze(struct maze_file* f, struct maze* m);
+
+
+#endif
@@ -0,0 +1,389 @@
+/**
+ * MESH
+ * Walls of a maze as a single triangle mesh (binary STL),
+ * built row by row with coplanar faces merged
+ */
+
+#include "mesh.h"
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+# define STL_HEADER         "mazegen"   // written into the 80 bytes of the STL header
+# define STL_HEADER_LEN     80
+# define STL_TRIANGLE_LEN   50          // normal, 3 vertices and attribute bytes
+# define MESH_BUFFER        (STL_TRIANGLE_LEN * 4096)
+
+// -----------------------------------------------------
+// PRIVATE METHOD
+// -----------------------------------------------------
+
+/**
+ * Write the triangles waiting in the buffer
+ *
+ * [IN]     mesh*: pointer to the mesh
+ * [OUT]    void
+ */
+static void flush(struct mesh* s) {
+    size_t  done = 0;   // bytes already written
+    ssize_t ret;        // bytes written by the last call
+
+    while (done < s->length && !s->error) {
+        ret = write(s->fd, s->buffer + done, s->length - done);
+        if (ret < 0)
+            s->error = 1;
+        else
+            done += ret;
+    }
+    s->length = 0;
+}
+
+/**
+ * Add a triangle to the buffer, as little endian floats
+ *
+ * [IN]     mesh*: pointer to the mesh
+ * [IN]     float*: outward normal
+ * [IN]     float*: the three vertices, counterclockwise seen from outside
+ * [OUT]    void
+ */
+static void add_triangle(struct mesh* s, float* n, float* a, float* b, float* c) {
+    uint8_t* t;
+
+    if (s->length + STL_TRIANGLE_LEN > MESH_BUFFER)
+        flush(s);
+
+    t = s->buffer + s->length;
+    memcpy(t, n, 3 * sizeof(float));
+    memcpy(t + 12, a, 3 * sizeof(float));
+    memcpy(t + 24, b, 3 * sizeof(float));
+    memcpy(t + 36, c, 3 * sizeof(float));
+    t[48] = t[49] = 0;
+
+    s->length += STL_TRIANGLE_LEN;
+    s->triangles++;
+}
+
+/**
+ * Add a rectangle as two triangles. The corners are turned around
+ * when they are clockwise seen from the side of the normal
+ *
+ * [IN]     mesh*: pointer to the mesh
+ * [IN]     float*: outward normal
+ * [IN]     float(*)[3]: the four corners, in order along the border
+ * [OUT]    void
+ */
+static void add_rect(struct mesh* s, float* n, float c[4][3]) {
+    float   u[3], v[3];
+    int     i;
+
+    for (i = 0; i < 3; i++) {
+        u[i] = c[1][i] - c[0][i];
+        v[i] = c[2][i] - c[0][i];
+    }
+
+    // the normal of the corners is u x v
+    if ((u[1] * v[2] - u[2] * v[1]) * n[0] + (u[2] * v[0] - u[0] * v[2]) * n[1] +
+            (u[0] * v[1] - u[1] * v[0]) * n[2] > 0) {
+        add_triangle(s, n, c[0], c[1], c[2]);
+        add_triangle(s, n, c[0], c[2], c[3]);
+    } else {
+        add_triangle(s, n, c[0], c[2], c[1]);
+        add_triangle(s, n, c[0], c[3], c[2]);
+    }
+}
+
+/**
+ * Position of the boundary before a block, along x or y
+ *
+ * [IN]     mesh*: pointer to the mesh
+ * [IN]     uint32_t: the block
+ * [OUT]    float: position of its boundary in meters
+ */
+static inline float edge(struct mesh* s, uint32_t k) {
+    return ((double)k - 0.5) * s->side;
+}
+
+/**
+ * Add the top and the bottom of rows r0..r1 of a run of walls
+ *
+ * [IN]     mesh*: pointer to the mesh
+ * [IN]     uint32_t: first and last row of the run
+ * [IN]     uint32_t: first column of the run and the one after it
+ * [OUT]    void
+ */
+static void face_z(struct mesh* s, uint32_t r0, uint32_t r1, uint32_t c0, uint32_t c1) {
+    float   x0 = edge(s, r0), x1 = edge(s, r1 + 1);
+    float   y0 = edge(s, c0), y1 = edge(s, c1);
+    float   h = s->side / 2;
+    float   up[3] = {0, 0, 1}, down[3] = {0, 0, -1};
+    float   top[4][3] = {{x0, y0, h}, {x1, y0, h}, {x1, y1, h}, {x0, y1, h}};
+    float   bottom[4][3] = {{x0, y0, -h}, {x1, y0, -h}, {x1, y1, -h}, {x0, y1, -h}};
+
+    add_rect(s, up, top);
+    add_rect(s, down, bottom);
+}
+
+/**
+ * Add a side facing along x, on the boundary before row k
+ *
+ * [IN]     mesh*: pointer to the mesh
+ * [IN]     uint32_t: the row
+ * [IN]     uint32_t: first column of the side and the one after it
+ * [IN]     int: 1 if the side faces +x, -1 if it faces -x
+ * [OUT]    void
+ */
+static void face_x(struct mesh* s, uint32_t k, uint32_t c0, uint32_t c1, int sign) {
+    float   x = edge(s, k);
+    float   y0 = edge(s, c0), y1 = edge(s, c1);
+    float   h = s->side / 2;
+    float   n[3] = {sign, 0, 0};
+    float   c[4][3] = {{x, y0, -h}, {x, y1, -h}, {x, y1, h}, {x, y0, h}};
+
+    add_rect(s, n, c);
+}
+
+/**
+ * Add a side facing along y, on the boundary before column j
+ *
+ * [IN]     mesh*: pointer to the mesh
+ * [IN]     uint32_t: the column
+ * [IN]     uint32_t: first and last row of the side
+ * [IN]     int: 1 if the side faces +y, -1 if it faces -y
+ * [OUT]    void
+ */
+static void face_y(struct mesh* s, uint32_t j, uint32_t r0, uint32_t r1, int sign) {
+    float   y = edge(s, j);
+    float   x0 = edge(s, r0), x1 = edge(s, r1 + 1);
+    float   h = s->side / 2;
+    float   n[3] = {0, sign, 0};
+    float   c[4][3] = {{x0, y, -h}, {x1, y, -h}, {x1, y, h}, {x0, y, h}};
+
+    add_rect(s, n, c);
+}
+
+/**
+ * Add the sides facing along x on the boundary before row k: a run of
+ * blocks that are walls on one side only
+ *
+ * [IN]     mesh*: pointer to the mesh
+ * [IN]     uint32_t: the row
+ * [IN]     uint8_t*: 1 for each wall of row k - 1
+ * [IN]     uint8_t*: 1 for each wall of row k
+ * [OUT]    void
+ */
+static void sides_x(struct mesh* s, uint32_t k, uint8_t* before, uint8_t* after) {
+    uint32_t    j, a;
+    int         sign;
+
+    for (j = 0; j < s->width; ) {
+        if (before[j] == after[j]) {
+            j++;
+            continue;
+        }
+
+        // the side faces away from the wall
+        sign = before[j] ? 1 : -1;
+        for (a = j; j < s->width && before[j] != after[j] && before[j] == before[a]; j++);
+        face_x(s, k, a, j, sign);
+    }
+}
+
+/**
+ * Free the memory allocated for the mesh
+ *
+ * [IN]     mesh*: pointer to the mesh
+ * [OUT]    void
+ */
+static void release(struct mesh* s) {
+    free(s->prev);
+    free(s->cur);
+    free(s->run_end);
+    free(s->run_row);
+    free(s->next_end);
+    free(s->next_row);
+    free(s->left);
+    free(s->right);
+    free(s->buffer);
+    s->prev = s->cur = s->buffer = NULL;
+    s->run_end = s->run_row = s->next_end = s->next_row = s->left = s->right = NULL;
+}
+
+// -----------------------------------------------------
+// PUBLIC METHOD
+// -----------------------------------------------------
+
+/**
+ * Create the STL file of a mesh. The walls are blocks centered at
+ * (x * side, y * side, 0) as the boxes of the world
+ *
+ * [IN]     mesh*: pointer to the mesh to be opened
+ * [IN]     char*: file name
+ * [IN]     uint32_t: maze width (number of block)
+ * [IN]     uint32_t: maze height (number of block)
+ * [IN]     double: side of a block in meters
+ * [OUT]    int: -1 in case of error, 0 in case of success
+ */
+int mesh_open(struct mesh* s, char* filename, uint32_t width, uint32_t height, double side) {
+    uint8_t     header[STL_HEADER_LEN + sizeof(uint32_t)];
+    uint32_t    j;
+
+    s->width = width;
+    s->height = height;
+    s->side = side;
+    s->rows = 0;
+    s->length = 0;
+    s->triangles = 0;
+    s->error = 0;
+
+    s->prev = calloc(width, 1);
+    s->cur = malloc(width);
+    s->run_end = calloc(width, sizeof(uint32_t));
+    s->run_row = malloc(width * sizeof(uint32_t));
+    s->next_end = malloc(width * sizeof(uint32_t));
+    s->next_row = malloc(width * sizeof(uint32_t));
+    s->left = malloc((width + 1) * sizeof(uint32_t));
+    s->right = malloc((width + 1) * sizeof(uint32_t));
+    s->buffer = malloc(MESH_BUFFER);
+
+    // out of memory
+    if (s->prev == NULL || s->cur == NULL || s->run_end == NULL || s->run_row == NULL || s->next_end == NULL ||
+            s->next_row == NULL || s->left == NULL || s->right == NULL || s->buffer == NULL) {
+        release(s);
+        return -1;
+    }
+    for (j = 0; j <= width; j++)
+        s->left[j] = s->right[j] = MESH_NONE;
+
+    s->fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (s->fd < 0) {
+        release(s);
+        return -1;
+    }
+
+    // the number of triangles is written again when the mesh is closed
+    memset(header, 0, sizeof(header));
+    memcpy(header, STL_HEADER, strlen(STL_HEADER));
+    memcpy(s->buffer, header, sizeof(header));
+    s->length = sizeof(header);
+
+    return 0;
+}
+
+/**
+ * Add a row of blocks to the mesh. Rows must be added from the first to
+ * the last one. The signature matches row_callback, so that rows can be
+ * added while they are streamed
+ *
+ * [IN]     void*: pointer to the mesh
+ * [IN]     uint32_t: row position in the maze (x position)
+ * [IN]     uint8_t*: blocks of the row
+ * [IN]     uint32_t: number of blocks in the row
+ * [OUT]    void
+ */
+void mesh_row(void* data, uint32_t x, uint8_t* row, uint32_t width) {
+    struct mesh*    s = data;
+    uint8_t*        cur = s->cur;
+    uint32_t*       swap;
+    uint32_t        j, a;
+    int             l, r;
+
+    for (j = 0; j < width; j++)
+        cur[j] = !!(row[j] & CELL_WALL);
+
+    // sides between the previous row and this one
+    sides_x(s, x, s->prev, cur);
+
+    // sides on the column boundaries go on while this row keeps them
+    for (j = 0; j <= width; j++) {
+        l = j < width && cur[j] && (j == 0 || !cur[j - 1]);
+        r = j > 0 && cur[j - 1] && (j == width || !cur[j]);
+        if (l && s->left[j] == MESH_NONE)
+            s->left[j] = x;
+        else if (!l && s->left[j] != MESH_NONE) {
+            face_y(s, j, s->left[j], x - 1, -1);
+            s->left[j] = MESH_NONE;
+        }
+        if (r && s->right[j] == MESH_NONE)
+            s->right[j] = x;
+        else if (!r && s->right[j] != MESH_NONE) {
+            face_y(s, j, s->right[j], x - 1, 1);
+            s->right[j] = MESH_NONE;
+        }
+    }
+
+    // a run of walls goes on when this row has the same run
+    memset(s->next_end, 0, width * sizeof(uint32_t));
+    for (j = 0; j < width; ) {
+        if (!cur[j]) {
+            j++;
+            continue;
+        }
+        for (a = j; j < width && cur[j]; j++);
+        s->next_end[a] = j;
+        s->next_row[a] = s->run_end[a] == j ? s->run_row[a] : x;
+    }
+
+    // top and bottom of the runs that end with the previous row
+    for (a = 0; a < width; a++)
+        if (s->run_end[a] && s->next_end[a] != s->run_end[a])
+            face_z(s, s->run_row[a], x - 1, a, s->run_end[a]);
+
+    swap = s->run_end;
+    s->run_end = s->next_end;
+    s->next_end = swap;
+    swap = s->run_row;
+    s->run_row = s->next_row;
+    s->next_row = swap;
+    memcpy(s->prev, cur, width);
+    s->rows = x + 1;
+}
+
+/**
+ * Add the whole maze to the mesh
+ *
+ * [IN]     mesh*: pointer to the mesh
+ * [IN]     maze*: pointer to the maze struct
+ * [OUT]    void
+ */
+void mesh_maze(struct mesh* s, struct maze* m) {
+    uint32_t i;     // iterate over the graph
+
+    for (i = 0; i < m->height; i++)
+        mesh_row(s, i, &CELL(m, i, 0), m->width);
+}
+
+/**
+ * Close the faces still open, write the number of triangles and close
+ * the file
+ *
+ * [IN]     mesh*: pointer to the mesh
+ * [OUT]    int: -1 if a write failed, 0 in case of success
+ */
+int mesh_close(struct mesh* s) {
+    uint32_t    count;
+    uint32_t    j;
+
+    // the last row is followed by no walls
+    memset(s->cur, 0, s->width);
+    sides_x(s, s->rows, s->prev, s->cur);
+    for (j = 0; j <= s->width; j++) {
+        if (s->left[j] != MESH_NONE)
+            face_y(s, j, s->left[j], s->rows - 1, -1);
+        if (s->right[j] != MESH_NONE)
+            face_y(s, j, s->right[j], s->rows - 1, 1);
+    }
+    for (j = 0; j < s->width; j++)
+        if (s->run_end[j])
+            face_z(s, s->run_row[j], s->rows - 1, j, s->run_end[j]);
+
+    flush(s);
+    count = s->triangles;
+    if (pwrite(s->fd, &count, sizeof(count), STL_HEADER_LEN) != sizeof(count))
+        s->error = 1;
+    if (close(s->fd))
+        s->error = 1;
+
+    release(s);
+    return s->error ? -1 : 0;
+}
@@ -0,0 +1,114 @@
+/**
+ * MESH
+ * Walls of a maze as a single triangle mesh (binary STL),
+ * built row by row with coplanar faces merged
+ *
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2018, Gabriele Ara, Gabriele Serra
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef MESH_H
+#define MESH_H
+
+#include "maze.h"
+
+# define MESH_NONE      UINT32_MAX  // no face is open at a column boundary
+
+/**
+ * STRUCT MESH
+ * Binary STL being written. Only the outer faces of the walls are
+ * written: faces between two wall blocks are never produced. Coplanar
+ * faces are merged into rectangles as the rows arrive: the top and the
+ * bottom of a run of walls grow along x while the next row has the same
+ * run, the sides along y grow while the next row keeps them, the sides
+ * along x are merged within the row
+ */
+struct mesh {
+    int                 fd;         // file descriptor of the STL
+    uint32_t            width;      // maze width (number of block)
+    uint32_t            height;     // maze height (number of block)
+    double              side;       // side of a block in meters
+    uint32_t            rows;       // rows already added
+    uint8_t*            prev;       // 1 for each wall of the previous row
+    uint8_t*            cur;        // 1 for each wall of the row being added
+    uint32_t*           run_end;    // end of the run starting at each column
+    uint32_t*           run_row;    // first row of the run starting at each column
+    uint32_t*           next_end;   // end of the runs of the row being added
+    uint32_t*           next_row;   // first row of the runs of the row being added
+    uint32_t*           left;       // first row of the face facing -y open at each column boundary
+    uint32_t*           right;      // first row of the face facing +y open at each column boundary
+    uint8_t*            buffer;     // triangles waiting to be written
+    size_t              length;     // bytes waiting in the buffer
+    uint32_t            triangles;  // triangles written
+    int                 error;      // 1 if a write failed
+};
+
+/**
+ * Create the STL file of a mesh. The walls are blocks centered at
+ * (x * side, y * side, 0) as the boxes of the world
+ * 
+ * [IN]     mesh*: pointer to the mesh to be opened
+ * [IN]     char*: file name
+ * [IN]     uint32_t: maze width (number of block)
+ * [IN]     uint32_t: maze height (number of block)
+ * [IN]     double: side of a block in meters
+ * [OUT]    int: -1 in case of error, 0 in case of success
+ */
+int mesh_open(struct mesh* s, char* filename, uint32_t width, uint32_t height, double side);
+
+/**
+ * Add a row of blocks to the mesh. Rows must be added from the first to
+ * the last one. The signature matches row_callback, so that rows can be
+ * added while they are streamed
+ * 
+ * [IN]     void*: pointer to the mesh
+ * [IN]     uint32_t: row position in the maze (x position)
+ * [IN]     uint8_t*: blocks of the row
+ * [IN]     uint32_t: number of blocks in the row
+ * [OUT]    void
+ */
+void mesh_row(void* data, uint32_t x, uint8_t* row, uint32_t width);
+
+/**
+ * Add the whole maze to the mesh
+ * 
+ * [IN]     mesh*: pointer to the mesh
+ * [IN]     maze*: pointer to the maze struct
+ * [OUT]    void
+ */
+void mesh_maze(struct mesh* s, struct maze* m);
+
+/**
+ * Close the faces still open, write the number of triangles and close
+ * the file
+ * 
+ * [IN]     mesh*: pointer to the mesh
+ * [OUT]    int: -1 if a write failed, 0 in case of success
+ */
+int mesh_close(struct mesh* s);
+
+
+#endif
@@ -0,0 +1,282 @@
+/**
+ * RENDER
+ * Drawing of a maze row by row, onto the terminal or into
+ * PGM/PBM images and ROS map_server maps
+ */
+
+#include "render.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+# define MAX_PATH_LEN   4096
+# define MAX_HEADER_LEN 64
+
+# define WALL_BLOCK     "█"    // full block
+# define WALL_ASCII     '#'
+# define WALL_PIXEL     0           // black
+# define FREE_PIXEL     254         // white (free in a map)
+
+// -----------------------------------------------------
+// PRIVATE METHOD
+// -----------------------------------------------------
+
+/**
+ * Write bytes into the destination of the drawing
+ *
+ * [IN]     renderer*: pointer to the renderer
+ * [IN]     const void*: bytes to be written
+ * [IN]     size_t: number of bytes
+ * [OUT]    void
+ */
+static void render_write(struct renderer* r, const void* bytes, size_t n) {
+    size_t  done = 0;   // bytes already written
+    ssize_t ret;        // bytes written by the last call
+
+    while (done < n && !r->error) {
+        ret = write(r->fd, (const char*)bytes + done, n - done);
+        if (ret < 0)
+            r->error = 1;
+        else
+            done += ret;
+    }
+}
+
+/**
+ * Open the file base.ext for writing
+ *
+ * [IN]     char*: file name without extension
+ * [IN]     char*: extension
+ * [OUT]    int: file descriptor, -1 in case of error
+ */
+static int open_file(char* base, char* ext) {
+    char path[MAX_PATH_LEN];
+
+    if (snprintf(path, MAX_PATH_LEN, "%s.%s", base, ext) >= MAX_PATH_LEN)
+        return -1;
+
+    return open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+}
+
+/**
+ * Write the yaml that describes a map to map_server. A pixel is a block
+ * and the center of block (0, 0) is the origin of the world
+ *
+ * [IN]     char*: file name without extension
+ * [IN]     double: side of a block in meters
+ * [OUT]    int: -1 in case of error, 0 in case of success
+ */
+static int write_yaml(char* base, double resolution) {
+    char    path[MAX_PATH_LEN];
+    char*   image;
+    FILE*   f;
+
+    if (snprintf(path, MAX_PATH_LEN, "%s.yaml", base) >= MAX_PATH_LEN)
+        return -1;
+    f = fopen(path, "w");
+    if (f == NULL)
+        return -1;
+
+    // the image is next to the yaml
+    image = strrchr(base, '/');
+    image = image != NULL ? image + 1 : base;
+
+    fprintf(f, "image: %s.pgm\n", image);
+    fprintf(f, "resolution: %g\n", resolution);
+    fprintf(f, "origin: [%g, %g, 0.0]\n", -resolution / 2, -resolution / 2);
+    fprintf(f, "negate: 0\n");
+    fprintf(f, "occupied_thresh: 0.65\n");
+    fprintf(f, "free_thresh: 0.196\n");
+
+    return fclose(f) ? -1 : 0;
+}
+
+// -----------------------------------------------------
+// PUBLIC METHOD
+// -----------------------------------------------------
+
+/**
+ * Parse the name of a format
+ *
+ * [IN]     char*: name (unicode, ascii, pgm, pbm or map)
+ * [OUT]    render_format: the format, RENDER_NONE if the name is unknown
+ */
+enum render_format render_parse(char* name) {
+    if (!strcmp(name, "unicode"))
+        return RENDER_UNICODE;
+    if (!strcmp(name, "ascii"))
+        return RENDER_ASCII;
+    if (!strcmp(name, "pgm"))
+        return RENDER_PGM;
+    if (!strcmp(name, "pbm"))
+        return RENDER_PBM;
+    if (!strcmp(name, "map"))
+        return RENDER_MAP;
+    return RENDER_NONE;
+}
+
+/**
+ * Open a drawing. Terminal formats are written to the standard output,
+ * images into base.pgm or base.pbm; a map is written into base.pgm and
+ * described by base.yaml
+ *
+ * [IN]     renderer*: pointer to the renderer to be opened
+ * [IN]     char*: file name without extension (not used by terminal formats)
+ * [IN]     render_format: format of the drawing
+ * [IN]     uint32_t: maze width (number of block)
+ * [IN]     uint32_t: maze height (number of block)
+ * [IN]     double: side of a block in meters (used by maps)
+ * [OUT]    int: -1 in case of error, 0 in case of success
+ */
+int render_open(struct renderer* r, char* base, enum render_format format,
+        uint32_t width, uint32_t height, double resolution) {
+    char header[MAX_HEADER_LEN];
+
+    r->format = format;
+    r->width = width;
+    r->height = height;
+    r->error = 0;
+    r->fd = -1;
+
+    // bytes of a row (of the whole map)
+    switch (format) {
+        case RENDER_UNICODE:
+            r->length = (size_t)width * strlen(WALL_BLOCK) + 1;
+            break;
+        case RENDER_ASCII:
+            r->length = (size_t)width + 1;
+            break;
+        case RENDER_PGM:
+            r->length = width;
+            break;
+        case RENDER_PBM:
+            r->length = ((size_t)width + 7) / 8;
+            break;
+        case RENDER_MAP:
+            r->length = (size_t)width * height;
+            break;
+        default:
+            return -1;
+    }
+
+    r->buffer = malloc(r->length);
+    if (r->buffer == NULL)
+        return -1;
+
+    if (format == RENDER_UNICODE || format == RENDER_ASCII)
+        r->fd = STDOUT_FILENO;
+    else
+        r->fd = open_file(base, format == RENDER_PBM ? "pbm" : "pgm");
+    if (r->fd < 0 || (format == RENDER_MAP && write_yaml(base, resolution))) {
+        r->error = 1;
+        render_close(r);
+        return -1;
+    }
+
+    // image header, a map is seen from above: x to the right, y up
+    if (format == RENDER_PGM)
+        snprintf(header, MAX_HEADER_LEN, "P5\n%u %u\n255\n", width, height);
+    else if (format == RENDER_PBM)
+        snprintf(header, MAX_HEADER_LEN, "P4\n%u %u\n", width, height);
+    else if (format == RENDER_MAP)
+        snprintf(header, MAX_HEADER_LEN, "P5\n%u %u\n255\n", height, width);
+    else
+        header[0] = '\0';
+    render_write(r, header, strlen(header));
+
+    return r->error ? -1 : 0;
+}
+
+/**
+ * Draw a row of blocks. Rows must be drawn from the first to the last one.
+ * The signature matches row_callback, so that rows can be drawn while
+ * they are streamed
+ *
+ * [IN]     void*: pointer to the renderer
+ * [IN]     uint32_t: row position in the maze (x position)
+ * [IN]     uint8_t*: blocks of the row
+ * [IN]     uint32_t: number of blocks in the row
+ * [OUT]    void
+ */
+void render_row(void* data, uint32_t x, uint8_t* row, uint32_t width) {
+    struct renderer*    r = data;
+    uint8_t*            b = r->buffer;
+    uint32_t            j;
+
+    switch (r->format) {
+        case RENDER_UNICODE:
+            for (j = 0; j < width; j++)
+                if (row[j] & CELL_WALL) {
+                    memcpy(b, WALL_BLOCK, strlen(WALL_BLOCK));
+                    b += strlen(WALL_BLOCK);
+                } else {
+                    *b++ = ' ';
+                }
+            *b++ = '\n';
+            break;
+        case RENDER_ASCII:
+            for (j = 0; j < width; j++)
+                *b++ = (row[j] & CELL_WALL) ? WALL_ASCII : ' ';
+            *b++ = '\n';
+            break;
+        case RENDER_PGM:
+            for (j = 0; j < width; j++)
+                *b++ = (row[j] & CELL_WALL) ? WALL_PIXEL : FREE_PIXEL;
+            break;
+        case RENDER_PBM:
+            // a set bit is a black pixel, the first one is the highest
+            memset(b, 0, r->length);
+            for (j = 0; j < width; j++)
+                b[j / 8] |= !!(row[j] & CELL_WALL) << (7 - j % 8);
+            b += r->length;
+            break;
+        case RENDER_MAP:
+            // row x of the maze is the column x of the image,
+            // block y goes up from the bottom row of the image
+            for (j = 0; j < width; j++)
+                b[(size_t)(width - 1 - j) * r->height + x] =
+                        (row[j] & CELL_WALL) ? WALL_PIXEL : FREE_PIXEL;
+            return;
+        default:
+            return;
+    }
+
+    render_write(r, r->buffer, b - r->buffer);
+}
+
+/**
+ * Draw the whole maze
+ *
+ * [IN]     renderer*: pointer to the renderer
+ * [IN]     maze*: pointer to the maze struct
+ * [OUT]    void
+ */
+void render_maze(struct renderer* r, struct maze* m) {
+    uint32_t i;     // iterate over the graph
+
+    for (i = 0; i < m->height; i++)
+        render_row(r, i, &CELL(m, i, 0), m->width);
+}
+
+/**
+ * Finish the drawing and close its file
+ *
+ * [IN]     renderer*: pointer to the renderer
+ * [OUT]    int: -1 if a write failed, 0 in case of success
+ */
+int render_close(struct renderer* r) {
+    // the map is written at once
+    if (r->format == RENDER_MAP && r->fd >= 0)
+        render_write(r, r->buffer, r->length);
+
+    if (r->fd >= 0 && r->fd != STDOUT_FILENO && close(r->fd))
+        r->error = 1;
+
+    free(r->buffer);
+    r->buffer = NULL;
+    r->fd = -1;
+
+    return r->error ? -1 : 0;
+}
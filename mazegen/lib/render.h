@@ -0,0 +1,123 @@
+/**
+ * RENDER
+ * Drawing of a maze row by row, onto the terminal or into
+ * PGM/PBM images and ROS map_server maps
+ *
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2018, Gabriele Ara, Gabriele Serra
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef RENDER_H
+#define RENDER_H
+
+#include "maze.h"
+
+/**
+ * ENUM RENDER_FORMAT
+ * Possible formats of a drawing
+ */
+enum render_format {
+    RENDER_NONE,        // nothing is drawn
+    RENDER_UNICODE,     // terminal, a full block for each wall
+    RENDER_ASCII,       // terminal, a '#' for each wall
+    RENDER_PGM,         // binary graymap, a black pixel for each wall
+    RENDER_PBM,         // binary bitmap, a black pixel for each wall
+    RENDER_MAP          // ROS map_server map: graymap seen from above and yaml
+};
+
+/**
+ * STRUCT RENDERER
+ * Destination of a drawing. A row of the maze is drawn into the buffer
+ * and written with a single call; a map is transposed (the rows of the
+ * maze are along the x axis of the world), so the whole image is kept
+ * and written when the renderer is closed
+ */
+struct renderer {
+    enum render_format  format;     // format of the drawing
+    int                 fd;         // file descriptor of the destination
+    uint32_t            width;      // maze width (number of block)
+    uint32_t            height;     // maze height (number of block)
+    uint8_t*            buffer;     // a row of the drawing (the whole map)
+    size_t              length;     // bytes of the buffer
+    int                 error;      // 1 if a write failed
+};
+
+/**
+ * Parse the name of a format
+ * 
+ * [IN]     char*: name (unicode, ascii, pgm, pbm or map)
+ * [OUT]    render_format: the format, RENDER_NONE if the name is unknown
+ */
+enum render_format render_parse(char* name);
+
+/**
+ * Open a drawing. Terminal formats are written to the standard output,
+ * images into base.pgm or base.pbm; a map is written into base.pgm and
+ * described by base.yaml
+ * 
+ * [IN]     renderer*: pointer to the renderer to be opened
+ * [IN]     char*: file name without extension (not used by terminal formats)
+ * [IN]     render_format: format of the drawing
+ * [IN]     uint32_t: maze width (number of block)
+ * [IN]     uint32_t: maze height (number of block)
+ * [IN]     double: side of a block in meters (used by maps)
+ * [OUT]    int: -1 in case of error, 0 in case of success
+ */
+int render_open(struct renderer* r, char* base, enum render_format format,
+        uint32_t width, uint32_t height, double resolution);
+
+/**
+ * Draw a row of blocks. Rows must be drawn from the first to the last one.
+ * The signature matches row_callback, so that rows can be drawn while
+ * they are streamed
+ * 
+ * [IN]     void*: pointer to the renderer
+ * [IN]     uint32_t: row position in the maze (x position)
+ * [IN]     uint8_t*: blocks of the row
+ * [IN]     uint32_t: number of blocks in the row
+ * [OUT]    void
+ */
+void render_row(void* data, uint32_t x, uint8_t* row, uint32_t width);
+
+/**
+ * Draw the whole maze
+ * 
+ * [IN]     renderer*: pointer to the renderer
+ * [IN]     maze*: pointer to the maze struct
+ * [OUT]    void
+ */
+void render_maze(struct renderer* r, struct maze* m);
+
+/**
+ * Finish the drawing and close its file
+ * 
+ * [IN]     renderer*: pointer to the renderer
+ * [OUT]    int: -1 if a write failed, 0 in case of success
+ */
+int render_close(struct renderer* r);
+
+
+#endif
@@ -0,0 +1,89 @@
+/**
+ * RNG
+ * Small and fast pseudo-random number generator
+ * (xoshiro256**) with an explicit, seedable state
+ */
+
+#include "rng.h"
+
+// -----------------------------------------------------
+// PRIVATE METHOD
+// -----------------------------------------------------
+
+/**
+ * Rotate left the bits of x
+ * 
+ * [IN]     uint64_t: bits to be rotated
+ * [IN]     int: number of positions
+ * [OUT]    uint64_t: rotated bits
+ */
+static uint64_t rotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+/**
+ * Draw the next number of a splitmix64 sequence, used to spread
+ * the seed over the whole state
+ * 
+ * [IN]     uint64_t*: splitmix64 state
+ * [OUT]    uint64_t: random bits
+ */
+static uint64_t splitmix64(uint64_t* x) {
+    uint64_t z = (*x += 0x9e3779b97f4a7c15ULL);
+
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+// -----------------------------------------------------
+// PUBLIC METHOD
+// -----------------------------------------------------
+
+/**
+ * Init the generator from a seed. The same seed always
+ * produces the same sequence
+ * 
+ * [IN]     rng*: pointer to the generator to be initialized
+ * [IN]     uint64_t: seed
+ * [OUT]    void
+ */
+void rng_seed(struct rng* r, uint64_t seed) {
+    int i;
+
+    for (i = 0; i < 4; i++)
+        r->s[i] = splitmix64(&seed);
+}
+
+/**
+ * Draw the next 64 random bits
+ * 
+ * [IN]     rng*: pointer to the generator
+ * [OUT]    uint64_t: random bits
+ */
+uint64_t rng_next(struct rng* r) {
+    uint64_t*   s = r->s;
+    uint64_t    result = rotl(s[1] * 5, 7) * 9;
+    uint64_t    t = s[1] << 17;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl(s[3], 45);
+
+    return result;
+}
+
+/**
+ * Draw a random number in [0, n) with a single draw
+ * 
+ * [IN]     rng*: pointer to the generator
+ * [IN]     uint32_t: upper bound (excluded), must be positive
+ * [OUT]    uint32_t: random number
+ */
+uint32_t rng_below(struct rng* r, uint32_t n) {
+    // scale the upper 32 bits into [0, n) (multiply-shift)
+    return (uint32_t)(((rng_next(r) >> 32) * n) >> 32);
+}
@@ -1,6 +1,7 @@
 /**
- * LIST
- * A simple linked list implementation using standard C library
+ * RNG
+ * Small and fast pseudo-random number generator
+ * (xoshiro256**) with an explicit, seedable state
  *
  * BSD 2-Clause License
  *
@@ -29,65 +30,46 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
-#ifndef LIST_H
-#define LIST_H
+#ifndef RNG_H
+#define RNG_H
 
-/**
- * STRUCT NODE
- * Represent each node of the list
- */
-struct node {
-    struct node*    next;   // contains the next node in list
-    char*           info;   // contains the 0-terminated info string
-};
+#include <stdint.h>
 
 /**
- * STRUCT NODE
- * Represent the list object
+ * STRUCT RNG
+ * State of a generator. Each generator is independent, so
+ * that different mazes can be generated at the same time
  */
-struct list {
-    int             n;      // contains the number of element in the list
-    struct node*    root;   // contains the root of the list
+struct rng {
+    uint64_t        s[4];   // xoshiro256** state
 };
 
 /**
- * Initialize the list in order to be used
- * 
- * [IN] struct list*: pointer to list to be initialized
- */
-void list_init(struct list* l);
-
-/**
- * Check if the list is empty
+ * Init the generator from a seed. The same seed always
+ * produces the same sequence
  * 
- * [IN] struct list*: pointer to list
- * [OUT] int: 1 if empty, 0 otherwise
+ * [IN]     rng*: pointer to the generator to be initialized
+ * [IN]     uint64_t: seed
+ * [OUT]    void
  */
-int list_is_empty(struct list* l);
+void rng_seed(struct rng* r, uint64_t seed);
 
 /**
- * Add the provided info str to the list
+ * Draw the next 64 random bits
  * 
- * [IN] struct list*: pointer to list
- * [IN] char*: str to be added to the list
- * [OUT] void
+ * [IN]     rng*: pointer to the generator
+ * [OUT]    uint64_t: random bits
  */
-void list_add_top(struct list* l, char* name);
+uint64_t rng_next(struct rng* r);
 
 /**
- * Remove the top element of the list
+ * Draw a random number in [0, n) with a single draw
  * 
- * [IN] struct list*: pointer to list
- * [OUT] void
+ * [IN]     rng*: pointer to the generator
+ * [IN]     uint32_t: upper bound (excluded), must be positive
+ * [OUT]    uint32_t: random number
  */
-void list_remove_top(struct list* l);
+uint32_t rng_below(struct rng* r, uint32_t n);
 
-/**
- * Return the pointer to info str of the top element of the list
- * 
- * [IN] struct list*: pointer to list
- * [OUT] char*: pointer to str info
- */
-char* list_get_top_info(struct list* l);
 
 #endif
\ No newline at end of file
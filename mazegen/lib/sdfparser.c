@@ -5,9 +5,18 @@
  */
 
 #include "sdfparser.h"
-#include "list.h"
 #include <stdlib.h>
 #include <stdio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <pthread.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
 
 // -------------------------------------
 // 
@@ -34,13 +43,137 @@ enum parser_state {
  * a file and build a document DOM
  */
 struct sdf_parser {
-	enum parser_state 	state;		// current state of parser
-	int 				position;	// current parser position [0 - filelength]
-	struct sdf_file* 	file;		// file that will be parsed
-	struct sdf_element* elem;		// current element that is built
-	struct list 		l;			// needed to check open/close pairing
+	enum parser_state 		state;		// current state of parser
+	size_t 					position;	// current parser position [0 - filelength]
+	struct sdf_file* 		file;		// file that will be parsed
+	struct sdf_structure 	structure;	// structural index of the file
+	struct sdf_document* 	document;	// document that is built
+	sdf_index 				elem;		// current element that is built
+	int 					depth;		// number of tags opened and not closed
+	size_t 					end;		// position where the parser stops
+	struct sdf_chunk* 		chunks;		// ranges parsed by other parsers (NULL)
+	uint32_t 				n_chunks;	// number of ranges
+	uint32_t 				chunk;		// next range to be skipped
+};
+
+/**
+ * STRUCT SDF_SPAN
+ * Range of the file that holds a whole element, from its <
+ * to the < of the next tag
+ */
+struct sdf_span {
+	size_t 					start;		// position of the element
+	size_t 					end;		// position of the next tag
+};
+
+/**
+ * STRUCT SDF_SPLIT_LEVEL
+ * Open element of a given depth, seen by the prescan
+ */
+struct sdf_split_level {
+	size_t 					start;		// position of the element
+	uint32_t 				children;	// elements opened at this depth under the same father
+	struct sdf_span 		last;		// last element closed at this depth
+};
+
+/**
+ * STRUCT SDF_CHUNK
+ * Consecutive sibling elements parsed into a document of
+ * their own, then moved into the whole document in place
+ * of an element of the skeleton (placeholder)
+ */
+struct sdf_chunk {
+	size_t 					start;		// position of the first element
+	size_t 					end;		// position after the last element
+	sdf_index 				placeholder;// element of the skeleton replaced by the first one
+	struct sdf_document 	document;	// elements of the chunk
+	sdf_atom* 				atoms;		// atom of the whole document for each atom of the chunk
+	sdf_index 				elements;	// first index of the other elements in the whole document
+	sdf_index 				attributes;	// first index of the attributes in the whole document
+};
+
+/**
+ * STRUCT SDF_SPLIT_JOB
+ * Chunks shared among the threads that parse (and then
+ * move) them
+ */
+struct sdf_split_job {
+	struct sdf_file* 		file;		// file that is parsed
+	struct sdf_structure* 	structure;	// structural index of the file
+	struct sdf_document* 	document;	// whole document
+	struct sdf_chunk* 		chunks;		// chunks of the file
+	uint32_t 				n_chunks;	// number of chunks
+	uint32_t 				next;		// next chunk to be handled (atomic)
+};
+
+/**
+ * STRUCT SDF_PRINT_JOB
+ * Children of an element shared among the threads that
+ * format them, each chunk of children into its own writer
+ */
+struct sdf_print_job {
+	struct sdf_document* 	document;	// document that is printed
+	sdf_index* 				children;	// children to be formatted
+	uint32_t 				n_children;	// number of children
+	struct sdf_writer* 		writers;	// one writer (in memory) for each chunk
+	uint32_t 				n_chunks;	// number of chunks
+	int 					depth;		// depth of the children
+	int 					compact;	// 1 to format without indentation
+	uint32_t 				next;		// next chunk to be formatted (atomic)
+};
+
+/**
+ * STRUCT SDF_ARENA_BLOCK
+ * A block of memory of the arena, blocks are
+ * chained from the newest to the oldest one
+ */
+struct sdf_arena_block {
+	struct sdf_arena_block* previous;	// previous block in chain
+	size_t 					size;		// usable bytes in data
+	char 					data[];		// block memory
+};
+
+#define SDF_ARENA_BLOCK 	4096		// size of the first arena block
+#define SDF_ARRAY_SIZE 		64			// initial capacity of node arrays
+#define SDF_ATOMS_SIZE 		64			// initial size of the atom hash table
+
+#define SDF_SPLIT_LEVELS 	16			// initial depth of the prescan stack
+#define SDF_SPLIT_CHUNKS 	8			// chunks for each thread of the parallel parser
+
+#define SDF_MASK(c) 		(1u << (c))	// classes mask of a single class
+
+/**
+ * ENUM WRITER_STATE
+ * Represent what the writer has written in the innermost
+ * open element
+ */
+enum writer_state {
+	WRITER_TAG,						// start tag written, attributes can follow <...
+	WRITER_TEXT,					// content written <...>content
+	WRITER_CHILDREN					// children written <...>\n<child/>\n
 };
 
+/**
+ * ENUM PULL_STATE
+ * Represent what the pull parser returned with the last event
+ */
+enum pull_state {
+	PULL_TAGS,						// the parser is between tags, text is skipped
+	PULL_OPENED,					// a start tag was returned, its content can follow <...>
+	PULL_SELF_CLOSED,				// a self-close tag was returned, its close follows <.../>
+	PULL_END,						// the end of input was returned
+	PULL_ERROR						// an error was returned
+};
+
+#define SDF_PULL_WINDOW 	65536		// default window size
+#define SDF_PULL_ATTRIBUTES 8			// initial capacity of the attributes of a tag
+#define SDF_PULL_TAGS 		16			// initial capacity of the open tags stack
+#define SDF_PULL_NAMES 		256			// initial bytes for the names of the open tags
+
+#define SDF_WRITER_BUFFER 	65536		// bytes collected before a write
+#define SDF_WRITER_TAGS 	16			// initial capacity of the open tags stack
+#define SDF_WRITER_IOVECS 	1024		// buffers written by each writev (IOV_MAX on Linux)
+#define SDF_WRITER_TABS 	"\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t"	// tabs written at once
 
 // ---------------------------------------
 //
@@ -49,31 +182,32 @@ struct sdf_parser {
 // ---------------------------------------
 
 /**
- * Return the file size of a file 
+ * Allocate a block of memory and fill with 0s. Exit in case of error 
  * 	
- * [IN] FILE*: file pointer
- * [OUT] long: file size
+ * [IN] int: count of element to be allocated
+ * [OUT] size_t: dimension of each element
  */
-long get_file_size(FILE* file) {
-	long size;	// it will contain file size
-	
-	// seek to the end of file and get stream position
-	fseek(file, 0L, SEEK_END);
-	size = ftell(file);
+void* alloc(int count, size_t dimension) {
+	void* ret = calloc(count, dimension);
+
+	// check if operation was performed
+	if(ret != NULL)
+		return ret;
 
-	// rewind back to file begin and return the size
-	rewind(file);
-	return size;
+	// Print and exit
+	printf("Out of memory. Please restart your machine.");
+	exit(-1);
 }
 
 /**
- * Allocate a block of memory and fill with 0s. Exit in case of error 
+ * Resize a block of memory. Exit in case of error 
  * 	
- * [IN] int: count of element to be allocated
- * [OUT] size_t: dimension of each element
+ * [IN] void*: block to be resized
+ * [IN] size_t: new dimension of the block
+ * [OUT] void*: the resized block
  */
-void* alloc(int count, size_t dimension) {
-	void* ret = calloc(count, dimension);
+void* sdf_realloc(void* ptr, size_t dimension) {
+	void* ret = realloc(ptr, dimension);
 
 	// check if operation was performed
 	if(ret != NULL)
@@ -84,42 +218,404 @@ void* alloc(int count, size_t dimension) {
 	exit(-1);
 }
 
+// ---------------------------------------
+//
+// PRIVATE: ARENA AND NODE ALLOCATION
+//
+// ---------------------------------------
+
 /**
- * Print a number n of tabs in the file F 
+ * Take n bytes from the arena, adding a new block when
+ * the current one is exhausted. Blocks grow geometrically
  * 	
- * [IN] int: number of tabs
- * [IN] FILE*: file in which print
+ * [IN] struct sdf_arena*: arena from which allocate
+ * [IN] size_t: number of bytes
+ * [OUT] void*: pointer to the allocated bytes
+ */
+void* sdf_arena_alloc(struct sdf_arena* arena, size_t n) {
+	struct sdf_arena_block* block;	// new block, if needed
+	size_t 					size;	// size of the new block
+	void* 					ret;
+
+	if(arena->block == NULL || arena->used + n > arena->block->size) {
+		size = (arena->block == NULL) ? SDF_ARENA_BLOCK : arena->block->size * 2;
+		if(size < n)
+			size = n;
+
+		block = alloc(1, sizeof(struct sdf_arena_block) + size);
+		block->previous = arena->block;
+		block->size = size;
+		arena->block = block;
+		arena->used = 0;
+	}
+
+	ret = arena->block->data + arena->used;
+	arena->used += n;
+	return ret;
+}
+
+/**
+ * Release all the blocks of an arena
+ * 	
+ * [IN] struct sdf_arena*: arena to be freed
  * [OUT] void
  */
-void print_tabs(int n, FILE* f) {
-	int i;	// used to iterate
+void sdf_arena_free(struct sdf_arena* arena) {
+	struct sdf_arena_block* previous;
 
-	for(i = 0; i < n; i++)
-		fprintf(f, "%s", "\t");
+	while(arena->block != NULL) {
+		previous = arena->block->previous;
+		free(arena->block);
+		arena->block = previous;
+	}
+
+	arena->used = 0;
+}
+
+/**
+ * Copy n chars into a 0-termined string allocated from the
+ * document arena and leave the result in s
+ * 	
+ * [IN] struct sdf_document*: document that owns the string
+ * [IN] struct sdf_string*: string to be filled
+ * [IN] char*: chars to be copied
+ * [IN] size_t: number of chars
+ * [OUT] void
+ */
+void sdf_string_set(struct sdf_document* d, struct sdf_string* s, char* str, size_t n) {
+	s->buffer = sdf_arena_alloc(&d->arena, n + 1);
+	s->length = n;
+	memcpy(s->buffer, str, n);
+	s->buffer[n] = '\0';
+}
+
+/**
+ * Hash of a name (FNV-1a)
+ * 	
+ * [IN] char*: name
+ * [IN] size_t: name length
+ * [OUT] uint32_t: hash of the name
+ */
+uint32_t sdf_atom_hash(const char* name, size_t length) {
+	uint32_t 	h = 2166136261u;
+	size_t 		i;
+
+	for(i = 0; i < length; i++)
+		h = (h ^ (uint8_t)name[i]) * 16777619u;
+
+	return h;
+}
+
+/**
+ * Find the slot of the hash table that holds a name, or the
+ * empty slot in which the name would be added
+ * 	
+ * [IN] struct sdf_atoms*: atom table
+ * [IN] char*: name
+ * [IN] size_t: name length
+ * [OUT] sdf_atom*: the slot
+ */
+sdf_atom* sdf_atom_slot(struct sdf_atoms* t, const char* name, size_t length) {
+	uint32_t 			i = sdf_atom_hash(name, length) & t->mask;
+	struct sdf_string* 	s;
+
+	// linear probing
+	for(; t->table[i] != SDF_NO_ATOM; i = (i + 1) & t->mask) {
+		s = t->names + t->table[i];
+		if(s->length == length && !memcmp(s->buffer, name, length))
+			break;
+	}
+
+	return t->table + i;
+}
+
+/**
+ * Double the hash table of an atom table (or create it)
+ * and add all its atoms again
+ * 	
+ * [IN] struct sdf_atoms*: atom table
+ * [OUT] void
+ */
+void sdf_atom_grow(struct sdf_atoms* t) {
+	uint32_t 	size = t->table ? (t->mask + 1) * 2 : SDF_ATOMS_SIZE;
+	sdf_atom 	a;
+
+	free(t->table);
+	t->table = sdf_realloc(NULL, size * sizeof(sdf_atom));
+	memset(t->table, 0xFF, size * sizeof(sdf_atom));
+	t->mask = size - 1;
+
+	for(a = 0; a < t->n_names; a++)
+		*sdf_atom_slot(t, t->names[a].buffer, t->names[a].length) = a;
+}
+
+/**
+ * Check that an element has an attribute
+ * 	
+ * [IN] struct sdf_document*: document that contains the element
+ * [IN] sdf_index: the element
+ * [IN] sdf_atom: name of the attribute, SDF_NO_ATOM for any element
+ * [OUT] int: 1 if the element has the attribute, 0 otherwise
+ */
+int sdf_attribute_has(struct sdf_document* d, sdf_index e, sdf_atom atom) {
+	sdf_index a;
+
+	if(atom == SDF_NO_ATOM)
+		return 1;
+
+	for(a = d->elements[e].attributes; a != SDF_NONE; a = d->attributes[a].next)
+		if(d->attributes[a].atom == atom)
+			return 1;
+
+	return 0;
+}
+
+/**
+ * Add a new element (without links) to the document
+ * 	
+ * [IN] struct sdf_document*: document in which add the element
+ * [OUT] sdf_index: index of the new element
+ */
+sdf_index sdf_element_new(struct sdf_document* d) {
+	struct sdf_element* e;
+
+	if(d->n_elements == d->elements_size) {
+		d->elements_size = d->elements_size ? d->elements_size * 2 : SDF_ARRAY_SIZE;
+		d->elements = sdf_realloc(d->elements, d->elements_size * sizeof(struct sdf_element));
+	}
+
+	e = d->elements + d->n_elements;
+	memset(e, 0, sizeof(struct sdf_element));
+	e->atom = SDF_NO_ATOM;
+	e->attributes = SDF_NONE;
+	e->children = SDF_NONE;
+	e->last_child = SDF_NONE;
+	e->father = SDF_NONE;
+	e->sibling = SDF_NONE;
+
+	return d->n_elements++;
+}
+
+/**
+ * Add a new attribute (without links) to the document
+ * 	
+ * [IN] struct sdf_document*: document in which add the attribute
+ * [OUT] sdf_index: index of the new attribute
+ */
+sdf_index sdf_attribute_new(struct sdf_document* d) {
+	struct sdf_attribute* a;
+
+	if(d->n_attributes == d->attributes_size) {
+		d->attributes_size = d->attributes_size ? d->attributes_size * 2 : SDF_ARRAY_SIZE;
+		d->attributes = sdf_realloc(d->attributes, d->attributes_size * sizeof(struct sdf_attribute));
+	}
+
+	a = d->attributes + d->n_attributes;
+	memset(a, 0, sizeof(struct sdf_attribute));
+	a->atom = SDF_NO_ATOM;
+	a->next = SDF_NONE;
+
+	return d->n_attributes++;
+}
+
+/**
+ * Return the element that the parser is building
+ * 	
+ * [IN] struct sdf_parser*: pointer to an sdf parser
+ * [OUT] struct sdf_element*: current element
+ */
+struct sdf_element* sdf_parser_elem(struct sdf_parser* p) {
+	return p->document->elements + p->elem;
+}
+
+/**
+ * Add an sdf children element and update the current element
+ * 	
+ * [IN] struct sdf_parser*: parser in which create children
+ * [OUT] void
+ */
+void use_children_elem(struct sdf_parser* p) {
+	sdf_index child = sdf_element_new(p->document);
+
+	p->document->elements[child].father = p->elem;
+	sdf_parser_elem(p)->children = child;
+	sdf_parser_elem(p)->last_child = child;
+	p->elem = child;
+}
+
+/**
+ * Add an sdf sibling element and update the current element
+ * 	
+ * [IN] struct sdf_parser*: parser in which create sibling
+ * [OUT] void
+ */
+void use_sibling_elem(struct sdf_parser* p) {
+	sdf_index sibling = sdf_element_new(p->document);
+	sdf_index father = sdf_parser_elem(p)->father;
+
+	p->document->elements[sibling].father = father;
+	sdf_parser_elem(p)->sibling = sibling;
+	if(father != SDF_NONE)
+		p->document->elements[father].last_child = sibling;
+	p->elem = sibling;
+}
+
+// ---------------------------------------
+//
+// PRIVATE: STRUCTURAL SCANNER
+//
+// ---------------------------------------
+
+/**
+ * Classes (as mask) of each character
+ */
+static const uint8_t sdf_classes[256] = {
+	['<'] = SDF_MASK(SDF_LT),
+	['>'] = SDF_MASK(SDF_GT),
+	['/'] = SDF_MASK(SDF_SLASH),
+	['='] = SDF_MASK(SDF_EQ),
+	['\''] = SDF_MASK(SDF_QUOTE),
+	['"'] = SDF_MASK(SDF_QUOTE),
+	[' '] = SDF_MASK(SDF_SPACE),
+	['\t'] = SDF_MASK(SDF_SPACE),
+	['\r'] = SDF_MASK(SDF_SPACE),
+	['\n'] = SDF_MASK(SDF_SPACE)
+};
+
+/**
+ * Index a block of 64 bytes, one byte at a time
+ * 	
+ * [IN] const char*: block to be indexed
+ * [IN] uint64_t*: the SDF_CLASSES words of the block
+ * [OUT] void
+ */
+void sdf_scan_block_scalar(const char* block, uint64_t* words) {
+	int 		i, c;	// iterate over bytes and classes
+	uint8_t 	mask;	// classes of the current byte
+
+	for(i = 0; i < 64; i++) {
+		mask = sdf_classes[(uint8_t)block[i]];
+		for(c = 0; mask != 0; c++, mask >>= 1)
+			words[c] |= (uint64_t)(mask & 1) << i;
+	}
 }
 
+#if defined(__SSE2__)
+
 /**
- * Allocate an sdf children element and update the passed pointer
+ * Index a block of 64 bytes, 16 bytes at a time
  * 	
- * [IN] struct sdf_element**: pointer to sdf element in which create children
+ * [IN] const char*: block to be indexed
+ * [IN] uint64_t*: the SDF_CLASSES words of the block
  * [OUT] void
  */
-void use_children_elem(struct sdf_element** elem) {
-	(*elem)->children = alloc(1, sizeof(struct sdf_element));
-	(*elem)->children->father = (*elem);
-	(*elem) = (*elem)->children;
+void sdf_scan_block_sse2(const char* block, uint64_t* words) {
+	__m128i 	v, sp;	// current 16 bytes and whitespaces
+	uint64_t 	shift;	// position of the 16 bytes in the block
+	int 		i;
+
+	for(i = 0; i < 4; i++) {
+		v = _mm_loadu_si128((const __m128i*)(block + 16 * i));
+		shift = 16 * i;
+
+		sp = _mm_or_si128(
+			_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\t'))),
+			_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\r')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\n'))));
+
+		words[SDF_LT] |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('<'))) << shift;
+		words[SDF_GT] |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('>'))) << shift;
+		words[SDF_SLASH] |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('/'))) << shift;
+		words[SDF_EQ] |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('='))) << shift;
+		words[SDF_QUOTE] |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_or_si128(
+			_mm_cmpeq_epi8(v, _mm_set1_epi8('\'')), _mm_cmpeq_epi8(v, _mm_set1_epi8('"')))) << shift;
+		words[SDF_SPACE] |= (uint64_t)(uint16_t)_mm_movemask_epi8(sp) << shift;
+	}
 }
 
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+
 /**
- * Allocate an sdf sibling element and update the passed pointer
+ * Index a block of 64 bytes, 32 bytes at a time
  * 	
- * [IN] struct sdf_element*: pointer to sdf element in which create sibling
+ * [IN] const char*: block to be indexed
+ * [IN] uint64_t*: the SDF_CLASSES words of the block
  * [OUT] void
  */
-void use_sibling_elem(struct sdf_element** elem) {
-	(*elem)->sibling = alloc(1, sizeof(struct sdf_element));
-	(*elem)->sibling->father = (*elem)->father;
-	(*elem) = (*elem)->sibling;
+__attribute__((target("avx2")))
+void sdf_scan_block_avx2(const char* block, uint64_t* words) {
+	__m256i 	v, sp;	// current 32 bytes and whitespaces
+	uint64_t 	shift;	// position of the 32 bytes in the block
+	int 		i;
+
+	for(i = 0; i < 2; i++) {
+		v = _mm256_loadu_si256((const __m256i*)(block + 32 * i));
+		shift = 32 * i;
+
+		sp = _mm256_or_si256(
+			_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t'))),
+			_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n'))));
+
+		words[SDF_LT] |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('<'))) << shift;
+		words[SDF_GT] |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('>'))) << shift;
+		words[SDF_SLASH] |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('/'))) << shift;
+		words[SDF_EQ] |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('='))) << shift;
+		words[SDF_QUOTE] |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_or_si256(
+			_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\'')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('"')))) << shift;
+		words[SDF_SPACE] |= (uint64_t)(uint32_t)_mm256_movemask_epi8(sp) << shift;
+	}
+}
+
+#endif
+
+/**
+ * Choose the implementation of the scanner that will be used
+ * 	
+ * [IN] enum sdf_scanner: requested implementation
+ * [OUT] enum sdf_scanner: implementation supported by the cpu
+ */
+enum sdf_scanner sdf_scanner_select(enum sdf_scanner scanner) {
+#if defined(__x86_64__) || defined(__i386__)
+	int avx2 = __builtin_cpu_supports("avx2");
+#else
+	int avx2 = 0;
+#endif
+#if defined(__SSE2__)
+	int sse2 = 1;
+#else
+	int sse2 = 0;
+#endif
+
+	if(scanner == SDF_SCAN_AVX2 && !avx2)
+		scanner = SDF_SCAN_AUTO;
+	if(scanner == SDF_SCAN_SSE2 && !sse2)
+		scanner = SDF_SCAN_AUTO;
+
+	if(scanner == SDF_SCAN_AUTO)
+		scanner = avx2 ? SDF_SCAN_AVX2 : (sse2 ? SDF_SCAN_SSE2 : SDF_SCAN_SCALAR);
+
+	return scanner;
+}
+
+/**
+ * Or together the words of the classes in mask
+ * 	
+ * [IN] struct sdf_structure*: structural index
+ * [IN] size_t: word to be read
+ * [IN] unsigned: classes mask
+ * [OUT] uint64_t: positions of the word that belong to any class
+ */
+uint64_t sdf_structure_word(struct sdf_structure* s, size_t word, unsigned mask) {
+	uint64_t* 	words = s->bits + word * SDF_CLASSES;
+	uint64_t 	ret = 0;
+	int 		c;
+
+	// branch-free: a class not in mask contributes with 0s
+	for(c = 0; c < SDF_CLASSES; c++)
+		ret |= words[c] & -(uint64_t)((mask >> c) & 1);
+
+	return ret;
 }
 
 // ---------------------------------------
@@ -157,11 +653,7 @@ void sdf_skip_char(struct sdf_parser* p, int n) {
  * [OUT] void
  */
 void sdf_go_next_tag(struct sdf_parser* p) {
-	while(p->file->buffer[p->position] != '<')
-		if(p->position < p->file->length)
-			p->position++;
-		else
-			break;
+	p->position = sdf_structure_next(&p->structure, p->position, SDF_MASK(SDF_LT));
 }
 
 /**
@@ -169,15 +661,10 @@ void sdf_go_next_tag(struct sdf_parser* p) {
  * return the next token pointer without updating the current one
  * 
  * [IN] struct parser*: pointer to an sdf parser
- * [OUT] int: next token pointer
+ * [OUT] size_t: next token pointer
  */
-int sdf_go_next_tag_dry(struct sdf_parser* p) {
-	int temp_pointer = p->position;
-
-	while(p->file->buffer[temp_pointer] != '<')
-		temp_pointer++;
-	
-	return temp_pointer;
+size_t sdf_go_next_tag_dry(struct sdf_parser* p) {
+	return sdf_structure_next(&p->structure, p->position, SDF_MASK(SDF_LT));
 }
 
 /**
@@ -187,8 +674,7 @@ int sdf_go_next_tag_dry(struct sdf_parser* p) {
  * [OUT] void
  */
 void sdf_next_token(struct sdf_parser* p) {
-	while(p->file->buffer[p->position] != '>')
-		p->position++;
+	p->position = sdf_structure_next(&p->structure, p->position, SDF_MASK(SDF_GT));
 }
 
 /**
@@ -209,39 +695,53 @@ void sdf_skip_whitespaces(struct sdf_parser* p) {
 // ---------------------------------------
 
 /**
- * Extract the next feature (attribute, content, tag name) and
- * leave the result in sdf_string s. Use the each of the separator
- * passed in sep. 
+ * Find the end of the next feature (attribute, content, tag name),
+ * namely the first position that contains a character of one of the
+ * separator classes passed in sep. The parser position is not updated.
  * 
  * [IN] struct parser*: pointer to the parser
- * [OUT] void
+ * [IN] unsigned: separator classes mask
+ * [OUT] size_t: position of the separator found
+ */
+size_t sdf_feature_scan(struct sdf_parser* p, unsigned sep) {
+	return sdf_structure_next(&p->structure, p->position, sep);
+}
+
+/**
+ * Find the end of a quoted attribute value, namely the position
+ * after the quote that matches the one at the current position
+ * 
+ * [IN] struct parser*: pointer to the parser
+ * [OUT] size_t: position after the closing quote
  */
-void sdf_feature_extract(struct sdf_parser* p, struct sdf_string** s, char* sep) {
-	int new_p_pos;	// temporary buffer pointer
-	int sep_i;		// iterate over separator
-	int check = 1;	// used to check logic condition over separator
+size_t sdf_quoted_scan(struct sdf_parser* p) {
+	char 	quote = p->file->buffer[p->position];
+	size_t 	new_p_pos = p->position;
 
-	// let's start from current pointer
-	new_p_pos = p->position;
+	do {
+		new_p_pos = sdf_structure_next(&p->structure, new_p_pos + 1, SDF_MASK(SDF_QUOTE));
+	} while(new_p_pos < p->file->length && p->file->buffer[new_p_pos] != quote);
 
-	// continue until one of the sepatator is found
-	while(1) {
-		for(sep_i = 0; sep_i < strlen(sep); sep_i++)
-			check = check && (p->file->buffer[new_p_pos] != sep[sep_i]);
+	return (new_p_pos < p->file->length) ? new_p_pos + 1 : new_p_pos;
+}
 
-		if(check)
-			new_p_pos++;
-		else
-			break;
-	}
-	
-	// allocate the struct and check for memory problem
-	(*s) = alloc(1, sizeof(struct sdf_string));
-	(*s)->length = new_p_pos - p->position;
-	(*s)->buffer = alloc((*s)->length, sizeof(char));
+/**
+ * Extract the next feature (attribute, content, tag name) and
+ * leave the result in sdf_string s. Use the each of the separator
+ * classes passed in sep. The string is a view into the file buffer,
+ * nothing is copied
+ * 
+ * [IN] struct parser*: pointer to the parser
+ * [IN] struct sdf_string*: the feature will be left here
+ * [IN] unsigned: separator classes mask
+ * [OUT] void
+ */
+void sdf_feature_extract(struct sdf_parser* p, struct sdf_string* s, unsigned sep) {
+	size_t new_p_pos = sdf_feature_scan(p, sep);
 
-	// fill the string, update the buffer pointer to skip =' and return
-	strncpy((*s)->buffer, p->file->buffer+(p->position+1), (*s)->length-1);
+	// point the string, update the buffer pointer to skip =' and return
+	s->buffer = p->file->buffer + (p->position + 1);
+	s->length = new_p_pos - p->position - 1;
 	p->position = new_p_pos;
 }
 
@@ -253,7 +753,8 @@ void sdf_feature_extract(struct sdf_parser* p, struct sdf_string** s, char* sep)
  * [OUT] void
  */
 void sdf_attributes_extract(struct sdf_parser* p) {
-	struct sdf_attribute* attribute; 	// new attribute
+	sdf_index 				index; 		// new attribute index
+	struct sdf_attribute* 	attribute; 	// new attribute
 
 	// ensure to be in a correct position
 	if(p->file->buffer[p->position] != ' ')
@@ -263,16 +764,28 @@ void sdf_attributes_extract(struct sdf_parser* p) {
 	while(p->file->buffer[p->position] != '>' 
 			&& p->file->buffer[p->position] != '/') {
 
-		// allocate attribute struct and check for memory problem
-		attribute = alloc(1, sizeof(struct sdf_attribute));
+		// allocate attribute struct
+		index = sdf_attribute_new(p->document);
+		attribute = p->document->attributes + index;
+
+		// extract names
+		sdf_feature_extract(p, &(attribute->name), SDF_MASK(SDF_EQ));
+		attribute->atom = sdf_atom_intern(p->document, &attribute->name);
 
-		// extract names and values
-		sdf_feature_extract(p, &(attribute->name), "=");
-		sdf_feature_extract(p, &(attribute->value), "> /");
+		// extract values, quoted ones can contain separators
+		if(sdf_classes[(uint8_t)p->file->buffer[p->position + 1]] & SDF_MASK(SDF_QUOTE)) {
+			p->position++;
+			attribute->value.buffer = p->file->buffer + p->position;
+			p->position = sdf_quoted_scan(p);
+			attribute->value.length = p->file->buffer + p->position - attribute->value.buffer;
+		} else {
+			sdf_feature_extract(p, &(attribute->value),
+				SDF_MASK(SDF_GT) | SDF_MASK(SDF_SPACE) | SDF_MASK(SDF_SLASH));
+		}
 
 		// attach attribute to head of list
-		attribute->next = p->elem->attributes;
-		p->elem->attributes = attribute;
+		attribute->next = sdf_parser_elem(p)->attributes;
+		sdf_parser_elem(p)->attributes = index;
 	}
 }
 
@@ -289,7 +802,7 @@ void sdf_content_extract(struct sdf_parser* p) {
 		return;
 
 	// extract feature content
-	sdf_feature_extract(p, &(p->elem->content), "<");
+	sdf_feature_extract(p, &(sdf_parser_elem(p)->content), SDF_MASK(SDF_LT));
 }
 
 /**
@@ -305,28 +818,35 @@ void sdf_element_extract(struct sdf_parser* p) {
 		return;
 
 	// extract feature name
-	sdf_feature_extract(p, &(p->elem->name), " >/");
+	sdf_feature_extract(p, &(sdf_parser_elem(p)->name),
+		SDF_MASK(SDF_SPACE) | SDF_MASK(SDF_GT) | SDF_MASK(SDF_SLASH));
+	sdf_parser_elem(p)->atom = sdf_atom_intern(p->document, &sdf_parser_elem(p)->name);
 }
 
 /**
- * Extract the tag name from a tag closing and leave the result
- * in the element passed
+ * Check that the tag name of a tag closing is equal
+ * to the name of the element passed
  * </name>
  * 
  * [IN] struct parser*: pointer to the parser
- * [IN] struct sdf_element*: pointer to the element in which result is left
- * [OUT] void
+ * [IN] struct sdf_element*: pointer to the element that must be closed
+ * [OUT] int: 1 if the names match, 0 otherwise
  */
-void sdf_close_extract(struct sdf_parser* p, struct sdf_element* elem) {
-	// ensure to be in a correct position
-	if(p->file->buffer[p->position] != '<')
-		return;
+int sdf_close_match(struct sdf_parser* p, struct sdf_element* elem) {
+	size_t new_p_pos; 	// end of the close tag name
 	
 	// skip </ token
 	sdf_skip_char(p, 1);
 
-	// extract close tag name
-	sdf_feature_extract(p, &(elem->name), ">");
+	// find close tag name
+	new_p_pos = sdf_feature_scan(p, SDF_MASK(SDF_GT));
+	p->position++;
+
+	// compare with the open tag name
+	if(new_p_pos - p->position != elem->name.length)
+		return 0;
+
+	return !memcmp(p->file->buffer + p->position, elem->name.buffer, elem->name.length);
 }
 
 // ---------------------------------------
@@ -342,25 +862,20 @@ void sdf_close_extract(struct sdf_parser* p, struct sdf_element* elem) {
  * [OUT] void
  */
 void sdf_close_tag(struct sdf_parser* p) {
-	struct sdf_element elem; // it will contain close tag name for validation
-
-	// extract close tag name
-	sdf_close_extract(p, &elem);
-
 	// a close tag must follow an open tag
-	if(list_is_empty(&p->l))
+	if(p->depth == 0)
 		sdf_state_ex("found </ (close token) in a wrong position. Check your SDF file.");
 
+	// return to father element
+	if(p->state == TAG_CLOSED)
+		p->elem = sdf_parser_elem(p)->father;
+
 	// check open/close constraint
-	if(strcmp(list_get_top_info(&p->l), elem.name->buffer))
+	if(!sdf_close_match(p, sdf_parser_elem(p)))
 		sdf_state_ex("not valid SDF file. Check that close tag follow its open tag.");
 	
 	// remove just closed tag
-	list_remove_top(&p->l);
-
-	// return to father element
-	if(p->state == TAG_CLOSED)
-		p->elem = p->elem->father;
+	p->depth--;
 	
 	// skip all whitespaces until a new tag is found
 	sdf_go_next_tag(p);
@@ -380,9 +895,6 @@ void sdf_self_close_tag(struct sdf_parser* p) {
 	if(p->state != TAG_OPEN)
 		sdf_state_ex("found /> (self-close token) in a wrong position. Check your SDF file.");
 
-	if(p->state == TAG_CLOSED)
-		p->elem = p->elem->father;
-
 	// skip all whitespaces until a new tag is found
 	sdf_go_next_tag(p);
 
@@ -421,9 +933,9 @@ void sdf_new_tag_open(struct sdf_parser* p) {
 	
 	// create sibling or children element
 	if (p->state == TAG_CLOSED)
-		use_sibling_elem(&p->elem);
+		use_sibling_elem(p);
 	else if (p->state == TAG_OPENED)
-		use_children_elem(&p->elem);
+		use_children_elem(p);
 		
 	// an open tag was found, so update parser state
 	p->state = TAG_OPEN;
@@ -439,13 +951,13 @@ void sdf_new_tag_open(struct sdf_parser* p) {
 /**
  * Handle close brackets of open tag ...> found by parser
  * (Check for the next token, if comment of another open go forward,
- * else extract content, put tag in list and update parser state)
+ * else extract content, count the tag as opened and update parser state)
  * 
  * [IN] struct parser*: pointer to the parser
  * [OUT] void
  */
 void sdf_new_tag_close(struct sdf_parser* p) {
-	int next_tag;	// temporary pointer
+	size_t next_tag;	// temporary pointer
 
 	// file is not in a valid format
 	if(p->state != TAG_OPEN)
@@ -465,93 +977,631 @@ void sdf_new_tag_close(struct sdf_parser* p) {
 		sdf_state_ex("not found an open tag after > (new tag close token). Check your SDF file.");
 
 	p->state = TAG_OPENED;
-	list_add_top(&p->l, p->elem->name->buffer);
+	p->depth++;
 }
 
-// ---------------------------------------
-//
-// PRIVATE: FREE MEMORY 
-//
-// ---------------------------------------
-
 /**
- * Recursive: free all allocated things of an attribute
+ * Prepare a parser to build a document from a range of the file.
+ * A new root is created, the elements after it become its siblings
  * 
- * [IN] struct sdf_attribute*: pointer to the attribute to be freed
+ * [IN] struct sdf_parser*: parser to be initialized
+ * [IN] struct sdf_file*: file to be parsed (already indexed into the parser)
+ * [IN] struct sdf_document*: document that is built
+ * [IN] size_t: position of the first tag
+ * [IN] size_t: position where the parser stops
  * [OUT] void
  */
-void sdf_attribute_close(struct sdf_attribute* attributes) {
-	if(attributes == NULL)
-		return;
-
-	sdf_attribute_close(attributes->next);
-	free(attributes->name->buffer);
-	free(attributes->value->buffer);
-	free(attributes->name);
-	free(attributes->value);
-	free(attributes);
+void sdf_parser_start(struct sdf_parser* p, struct sdf_file* file, struct sdf_document* d,
+		size_t start, size_t end) {
+	sdf_document_init(d);
+	d->root = sdf_element_new(d);
+
+	p->file = file;
+	p->position = start;
+	p->end = end;
+	p->state = BEGIN;
+	p->document = d;
+	p->elem = d->root;
+	p->depth = 0;
+	p->chunks = NULL;
+	p->n_chunks = 0;
+	p->chunk = 0;
 }
 
 /**
- * Free string related to the content of a tag
+ * Skip a chunk parsed by another parser, leaving a placeholder
+ * element where its first element would be
  * 
- * [IN] struct sdf_string*: pointer to the string to be freed
+ * [IN] struct parser*: pointer to the parser
  * [OUT] void
  */
-void sdf_content_close(struct sdf_string* content) {
-	free(content->buffer);
-	free(content);
-}
+void sdf_chunk_skip(struct sdf_parser* p) {
+	struct sdf_chunk* c = p->chunks + p->chunk++;
 
-/**
- * Free string related to the name of a tag
- * 
- * [IN] struct sdf_string*: pointer to the string to be freed
- * [OUT] void
- */
-void sdf_name_close(struct sdf_string* name) {
-	free(name->buffer);
-	free(name);
+	// create sibling or children element, as for an open tag
+	if (p->state == TAG_CLOSED)
+		use_sibling_elem(p);
+	else if (p->state == TAG_OPENED)
+		use_children_elem(p);
+
+	// go on as if the chunk was closed
+	c->placeholder = p->elem;
+	p->position = c->end;
+	p->state = TAG_CLOSED;
 }
 
 /**
- * Recursive: free all contents of an element, its children and siblings
+ * Run the state machine over the index until the end of
+ * the range is reached
  * 
- * [IN] struct sdf_element*: pointer to the element to be freed
+ * [IN] struct parser*: pointer to the parser
  * [OUT] void
  */
-void sdf_element_close(struct sdf_element* element) {
-	if(element == NULL)
-		return;
-
-	if(element->content != NULL)
-		sdf_content_close(element->content);
-	if(element->name != NULL)
-		sdf_name_close(element->name);
-	if(element->attributes != NULL)
-		sdf_attribute_close(element->attributes);
-
-	sdf_element_close(element->children);
-	sdf_element_close(element->sibling);
-
-	free(element);
+void sdf_parser_run(struct sdf_parser* p) {
+	char* b = p->file->buffer;
+
+	while(p->position < p->end) {
+		if(p->chunk < p->n_chunks && p->position == p->chunks[p->chunk].start)
+			sdf_chunk_skip(p);
+		else if(!strncmp(b+p->position, "<!", 2))
+			sdf_comment_tag(p);
+		else if(!strncmp(b+p->position, "</", 2))
+			sdf_close_tag(p);
+		else if(!strncmp(b+p->position, "/>", 2))
+			sdf_self_close_tag(p);
+		else if(!strncmp(b+p->position, ">", 1))
+			sdf_new_tag_close(p);
+		else if(!strncmp(b+p->position, "<", 1))
+			sdf_new_tag_open(p);
+	}
 }
 
 // ---------------------------------------
 //
-// PUBLIC: SYNTAX CHECKER
+// PRIVATE: PARALLEL PARSER
 //
 // ---------------------------------------
 
 /**
- * Check if the content of an sdf file is correct wrt syntax <>
+ * Find the > that ends a start tag, quoted values can contain it
  * 
- * [IN] struct sdf_file*: pointer to the struct to be filled
- * [OUT] int: 1 if correct, 0 otherwise
+ * [IN] struct sdf_structure*: structural index
+ * [IN] char*: indexed buffer
+ * [IN] size_t: position of <
+ * [OUT] size_t: position found or buffer length
  */
-int syntax_check(struct sdf_file* file) {
-	long 				i;			// iterate over file buffer
-	enum parser_state	state;		// used to check current parser state
+size_t sdf_split_tag_end(struct sdf_structure* s, char* b, size_t position) {
+	char quote;		// quote of the value that is being skipped
+
+	while((position = sdf_structure_next(s, position + 1,
+			SDF_MASK(SDF_GT) | SDF_MASK(SDF_QUOTE))) < s->length && b[position] != '>') {
+		quote = b[position];
+		do {
+			position = sdf_structure_next(s, position + 1, SDF_MASK(SDF_QUOTE));
+		} while(position < s->length && b[position] != quote);
+	}
+
+	return position;
+}
+
+/**
+ * Add a span to a growing array of spans
+ * 
+ * [IN] struct sdf_span**: array of spans
+ * [IN] size_t*: spans in use
+ * [IN] size_t*: spans allocated
+ * [IN] struct sdf_span*: span to be added
+ * [OUT] void
+ */
+void sdf_split_push(struct sdf_span** spans, size_t* n, size_t* size, struct sdf_span* span) {
+	if(*n == *size) {
+		*size = *size ? *size * 2 : SDF_ARRAY_SIZE;
+		*spans = sdf_realloc(*spans, *size * sizeof(struct sdf_span));
+	}
+
+	(*spans)[(*n)++] = *span;
+}
+
+/**
+ * Prescan of the file: find the first element (from the root
+ * down through only children) that has more than one child and
+ * return the span of each of its children. Tags are walked over
+ * the structural index, nothing is extracted
+ * 
+ * [IN] struct sdf_structure*: structural index
+ * [IN] char*: indexed buffer
+ * [IN] struct sdf_span**: the array of spans will be left here (NULL if none)
+ * [OUT] size_t: number of spans
+ */
+size_t sdf_split_scan(struct sdf_structure* s, char* b, struct sdf_span** spans) {
+	struct sdf_split_level* levels;		// open elements, one for each depth
+	struct sdf_span 		span;		// element just closed
+	int 					levels_size = SDF_SPLIT_LEVELS;
+	int 					depth = 0;	// number of open elements
+	int 					split = -1;	// depth of the children to be split
+	size_t 					n = 0, size = 0;
+	size_t 					position, gt;
+
+	*spans = NULL;
+	levels = alloc(levels_size, sizeof(struct sdf_split_level));
+
+	position = sdf_structure_next(s, 0, SDF_MASK(SDF_LT));
+	while(position < s->length) {
+		span.start = position;
+
+		// comments are skipped up to the first >
+		if(b[position + 1] == '!') {
+			gt = sdf_structure_next(s, position, SDF_MASK(SDF_GT));
+			position = sdf_structure_next(s, gt, SDF_MASK(SDF_LT));
+			continue;
+		}
+
+		if(b[position + 1] == '/') {
+			// stop when the father of the spans is closed
+			if(--depth < 0 || depth < split)
+				break;
+			span.start = levels[depth].start;
+			gt = sdf_structure_next(s, position, SDF_MASK(SDF_GT));
+		} else {
+			if(depth + 1 >= levels_size) {
+				levels_size *= 2;
+				levels = sdf_realloc(levels, levels_size * sizeof(struct sdf_split_level));
+			}
+			levels[depth].start = position;
+			levels[depth + 1].children = 0;
+
+			// the second child of an only child is the first split
+			if(++levels[depth].children == 2 && split < 0) {
+				split = depth;
+				sdf_split_push(spans, &n, &size, &levels[depth].last);
+			}
+
+			gt = sdf_split_tag_end(s, b, position);
+			if(gt < s->length && b[gt - 1] != '/') {
+				depth++;
+				position = sdf_structure_next(s, gt, SDF_MASK(SDF_LT));
+				continue;
+			}
+		}
+
+		// an element was closed at this depth
+		position = sdf_structure_next(s, gt, SDF_MASK(SDF_LT));
+		span.end = position;
+		if(depth == split)
+			sdf_split_push(spans, &n, &size, &span);
+		else if(split < 0)
+			levels[depth].last = span;
+	}
+
+	free(levels);
+	return n;
+}
+
+/**
+ * Index of an element of a chunk in the whole document
+ * 
+ * [IN] struct sdf_chunk*: the chunk
+ * [IN] sdf_index: element of the chunk document
+ * [OUT] sdf_index: element of the whole document
+ */
+sdf_index sdf_chunk_index(struct sdf_chunk* c, sdf_index e) {
+	if(e == SDF_NONE)
+		return SDF_NONE;
+
+	return e == 0 ? c->placeholder : c->elements + e - 1;
+}
+
+/**
+ * Move elements and attributes of a chunk into the whole document,
+ * at the indexes reserved for them. The first element takes the
+ * place of the placeholder, the chunk document is freed
+ * 
+ * [IN] struct sdf_document*: whole document
+ * [IN] struct sdf_chunk*: the chunk
+ * [OUT] void
+ */
+void sdf_chunk_stitch(struct sdf_document* d, struct sdf_chunk* c) {
+	struct sdf_document* 	s = &c->document;
+	struct sdf_element 		placeholder = d->elements[c->placeholder];
+	struct sdf_element* 	e;
+	struct sdf_attribute* 	a;
+	sdf_index 				i, last = c->placeholder;
+
+	for(i = 0; i < s->n_attributes; i++) {
+		a = d->attributes + c->attributes + i;
+		*a = s->attributes[i];
+		a->atom = c->atoms[a->atom];
+		if(a->next != SDF_NONE)
+			a->next += c->attributes;
+	}
+
+	for(i = 0; i < s->n_elements; i++) {
+		e = d->elements + sdf_chunk_index(c, i);
+		*e = s->elements[i];
+		e->atom = c->atoms[e->atom];
+		if(e->attributes != SDF_NONE)
+			e->attributes += c->attributes;
+		e->children = sdf_chunk_index(c, e->children);
+		e->last_child = sdf_chunk_index(c, e->last_child);
+		e->sibling = sdf_chunk_index(c, e->sibling);
+
+		// the siblings of the chunk are linked as the placeholder was
+		if(e->father == SDF_NONE) {
+			e->father = placeholder.father;
+			if(e->sibling == SDF_NONE) {
+				e->sibling = placeholder.sibling;
+				last = sdf_chunk_index(c, i);
+			}
+		} else {
+			e->father = sdf_chunk_index(c, e->father);
+		}
+	}
+
+	if(placeholder.father != SDF_NONE && d->elements[placeholder.father].last_child == c->placeholder)
+		d->elements[placeholder.father].last_child = last;
+
+	sdf_document_close(s);
+	free(c->atoms);
+}
+
+/**
+ * Worker of the parallel parser: parse chunks into their own
+ * documents until all the chunks are taken
+ * 
+ * [IN] void*: the job (struct sdf_split_job*)
+ * [OUT] void*: NULL
+ */
+void* sdf_parse_worker(void* arg) {
+	struct sdf_split_job* 	job = arg;
+	struct sdf_chunk* 		c;
+	struct sdf_parser 		p;
+	uint32_t 				i;
+
+	p.structure = *job->structure;
+	while((i = __atomic_fetch_add(&job->next, 1, __ATOMIC_RELAXED)) < job->n_chunks) {
+		c = job->chunks + i;
+		sdf_parser_start(&p, job->file, &c->document, c->start, c->end);
+		sdf_parser_run(&p);
+	}
+
+	return NULL;
+}
+
+/**
+ * Worker of the parallel parser: move chunks into the whole
+ * document until all the chunks are taken
+ * 
+ * [IN] void*: the job (struct sdf_split_job*)
+ * [OUT] void*: NULL
+ */
+void* sdf_stitch_worker(void* arg) {
+	struct sdf_split_job* 	job = arg;
+	uint32_t 				i;
+
+	while((i = __atomic_fetch_add(&job->next, 1, __ATOMIC_RELAXED)) < job->n_chunks)
+		sdf_chunk_stitch(job->document, job->chunks + i);
+
+	return NULL;
+}
+
+/**
+ * Run a worker on a pool of threads, this thread works too.
+ * If a thread can't start the others do its work
+ * 
+ * [IN] void* (*)(void*): the worker
+ * [IN] void*: the job, shared by the threads
+ * [IN] int: number of threads
+ * [OUT] void
+ */
+void sdf_threads_run(void* (*worker)(void*), void* job, int threads) {
+	pthread_t* 	workers = alloc(threads, sizeof(pthread_t));
+	int 		i, started;
+
+	for(started = 0; started < threads - 1; started++)
+		if(pthread_create(workers + started, NULL, worker, job) != 0)
+			break;
+	worker(job);
+	for(i = 0; i < started; i++)
+		pthread_join(workers[i], NULL);
+
+	free(workers);
+}
+
+/**
+ * Group consecutive spans into chunks of about the same size
+ * 
+ * [IN] struct sdf_span*: spans of the elements to be split
+ * [IN] size_t: number of spans
+ * [IN] uint32_t: wanted number of chunks
+ * [IN] uint32_t*: number of chunks will be left here
+ * [OUT] struct sdf_chunk*: the chunks
+ */
+struct sdf_chunk* sdf_split_chunks(struct sdf_span* spans, size_t n, uint32_t wanted, uint32_t* n_chunks) {
+	struct sdf_chunk* 	chunks;
+	size_t 				bytes = (spans[n - 1].end - spans[0].start) / wanted + 1;	// bytes of a chunk
+	size_t 				i;
+
+	if(wanted > n)
+		wanted = n;
+	chunks = alloc(wanted, sizeof(struct sdf_chunk));
+
+	*n_chunks = 0;
+	for(i = 0; i < n; i++) {
+		if(*n_chunks == 0 || spans[i].start - chunks[*n_chunks - 1].start >= bytes)
+			chunks[(*n_chunks)++].start = spans[i].start;
+		chunks[*n_chunks - 1].end = spans[i].end;
+	}
+
+	return chunks;
+}
+
+// ---------------------------------------
+//
+// PRIVATE: PULL PARSER
+//
+// ---------------------------------------
+
+/**
+ * Stop the pull parser, the error is returned by all the next calls
+ * 
+ * [IN] struct sdf_pull_parser*: pointer to the pull parser
+ * [IN] char*: reason of the error
+ * [OUT] enum sdf_event: SDF_EVENT_ERROR
+ */
+enum sdf_event sdf_pull_error(struct sdf_pull_parser* p, char* error) {
+	p->error = error;
+	p->state = PULL_ERROR;
+	return SDF_EVENT_ERROR;
+}
+
+/**
+ * Ask for more input, since the next tag is not whole into the window.
+ * It is an error if the input is finished or the window is already full
+ * 
+ * [IN] struct sdf_pull_parser*: pointer to the pull parser
+ * [OUT] enum sdf_event: SDF_EVENT_NONE or SDF_EVENT_ERROR
+ */
+enum sdf_event sdf_pull_more(struct sdf_pull_parser* p) {
+	if(p->last)
+		return sdf_pull_error(p, "unexpected end of input");
+	if(p->start == 0 && p->length == p->size)
+		return sdf_pull_error(p, "tag larger than the window");
+
+	return SDF_EVENT_NONE;
+}
+
+/**
+ * Find a character into the window
+ * 
+ * [IN] struct sdf_pull_parser*: pointer to the pull parser
+ * [IN] size_t: first position to be checked
+ * [IN] char: character to be found
+ * [OUT] size_t: position found or window length
+ */
+size_t sdf_pull_find(struct sdf_pull_parser* p, size_t position, char c) {
+	char* found = memchr(p->window + position, c, p->length - position);
+
+	return found != NULL ? (size_t)(found - p->window) : p->length;
+}
+
+/**
+ * Find a string into the window (e.g. the end of a comment -->)
+ * 
+ * [IN] struct sdf_pull_parser*: pointer to the pull parser
+ * [IN] size_t: first position to be checked
+ * [IN] const char*: string to be found (must be 0-termined)
+ * [OUT] size_t: position found or window length
+ */
+size_t sdf_pull_find_string(struct sdf_pull_parser* p, size_t position, const char* str) {
+	size_t n = strlen(str);
+
+	while((position = sdf_pull_find(p, position, str[0])) + n <= p->length) {
+		if(!memcmp(p->window + position, str, n))
+			return position;
+		position++;
+	}
+
+	return p->length;
+}
+
+/**
+ * Find the > that ends a start tag, quoted values can contain it
+ * 
+ * [IN] struct sdf_pull_parser*: pointer to the pull parser
+ * [IN] size_t: first position to be checked
+ * [OUT] size_t: position found or window length
+ */
+size_t sdf_pull_tag_end(struct sdf_pull_parser* p, size_t position) {
+	char quote = 0;		// quote of the value that is being skipped
+	char c;
+
+	for(; position < p->length; position++) {
+		c = p->window[position];
+		if(quote) {
+			if(c == quote)
+				quote = 0;
+		} else if(c == '>') {
+			return position;
+		} else if(sdf_classes[(uint8_t)c] & SDF_MASK(SDF_QUOTE)) {
+			quote = c;
+		}
+	}
+
+	return p->length;
+}
+
+/**
+ * Skip the whitespaces of a tag
+ * 
+ * [IN] struct sdf_pull_parser*: pointer to the pull parser
+ * [IN] size_t: first position to be checked
+ * [IN] size_t: end of the tag
+ * [OUT] size_t: first position that is not a whitespace
+ */
+size_t sdf_pull_skip_spaces(struct sdf_pull_parser* p, size_t position, size_t end) {
+	while(position < end && sdf_classes[(uint8_t)p->window[position]] & SDF_MASK(SDF_SPACE))
+		position++;
+
+	return position;
+}
+
+/**
+ * Skip a feature of a tag (tag or attribute name, value without quotes)
+ * 
+ * [IN] struct sdf_pull_parser*: pointer to the pull parser
+ * [IN] size_t: first position to be checked
+ * [IN] size_t: end of the tag
+ * [IN] unsigned: separator classes mask
+ * [OUT] size_t: position of the separator found or end of the tag
+ */
+size_t sdf_pull_skip_feature(struct sdf_pull_parser* p, size_t position, size_t end, unsigned sep) {
+	while(position < end && !(sdf_classes[(uint8_t)p->window[position]] & sep))
+		position++;
+
+	return position;
+}
+
+/**
+ * Extract tag name and attributes of a start tag
+ * <tag attr1='value' attr2='value2' ..>
+ * 
+ * [IN] struct sdf_pull_parser*: pointer to the pull parser
+ * [IN] size_t: position of <
+ * [IN] size_t: position of > (of / for a self-close tag)
+ * [OUT] int: 0 if correct, -1 if the tag is not valid
+ */
+int sdf_pull_tag_extract(struct sdf_pull_parser* p, size_t position, size_t end) {
+	char* 					b = p->window;
+	struct sdf_attribute* 	attribute;	// new attribute
+	size_t 					first;		// first position of a feature
+
+	// extract tag name
+	first = position + 1;
+	position = sdf_pull_skip_feature(p, first, end, SDF_MASK(SDF_SPACE));
+	if(position == first)
+		return -1;
+	p->name.buffer = b + first;
+	p->name.length = position - first;
+
+	// extract names and values
+	p->n_attributes = 0;
+	while((position = sdf_pull_skip_spaces(p, position, end)) < end) {
+		if(p->n_attributes == p->attributes_size) {
+			p->attributes_size *= 2;
+			p->attributes = sdf_realloc(p->attributes,
+				p->attributes_size * sizeof(struct sdf_attribute));
+		}
+		attribute = p->attributes + p->n_attributes;
+
+		// extract name, it must be followed by =
+		first = position;
+		position = sdf_pull_skip_feature(p, first, end, SDF_MASK(SDF_EQ) | SDF_MASK(SDF_SPACE));
+		if(position == first || position == end || b[position] != '=')
+			return -1;
+		attribute->name.buffer = b + first;
+		attribute->name.length = position - first;
+
+		// extract value, quoted ones keep their quotes
+		first = ++position;
+		if(position < end && sdf_classes[(uint8_t)b[position]] & SDF_MASK(SDF_QUOTE)) {
+			position = sdf_pull_find(p, position + 1, b[first]);
+			if(position >= end)
+				return -1;
+			position++;
+		} else {
+			position = sdf_pull_skip_feature(p, position, end, SDF_MASK(SDF_SPACE));
+		}
+		attribute->value.buffer = b + first;
+		attribute->value.length = position - first;
+
+		// chain the attributes in order
+		attribute->atom = SDF_NO_ATOM;
+		attribute->next = SDF_NONE;
+		if(p->n_attributes > 0)
+			attribute[-1].next = p->n_attributes;
+		p->n_attributes++;
+	}
+
+	return 0;
+}
+
+/**
+ * Remember the name of a tag just opened, the window can drop it
+ * 
+ * [IN] struct sdf_pull_parser*: pointer to the pull parser
+ * [IN] struct sdf_string*: tag name
+ * [OUT] void
+ */
+void sdf_pull_push(struct sdf_pull_parser* p, struct sdf_string* name) {
+	if(p->depth == p->marks_size) {
+		p->marks_size *= 2;
+		p->marks = sdf_realloc(p->marks, p->marks_size * sizeof(size_t));
+	}
+	while(p->tags_length + name->length > p->tags_size) {
+		p->tags_size *= 2;
+		p->tags = sdf_realloc(p->tags, p->tags_size);
+	}
+
+	p->marks[p->depth++] = p->tags_length;
+	memcpy(p->tags + p->tags_length, name->buffer, name->length);
+	p->tags_length += name->length;
+}
+
+/**
+ * Forget the innermost open tag, its name is left as name of the event
+ * 
+ * [IN] struct sdf_pull_parser*: pointer to the pull parser
+ * [OUT] void
+ */
+void sdf_pull_pop(struct sdf_pull_parser* p) {
+	p->depth--;
+	p->name.buffer = p->tags + p->marks[p->depth];
+	p->name.length = p->tags_length - p->marks[p->depth];
+	p->tags_length = p->marks[p->depth];
+}
+
+/**
+ * Check that the tag name of a tag closing is equal to the
+ * name of the innermost open tag
+ * </name>
+ * 
+ * [IN] struct sdf_pull_parser*: pointer to the pull parser
+ * [IN] size_t: position of <
+ * [IN] size_t: position of >
+ * [OUT] int: 1 if the names match, 0 otherwise
+ */
+int sdf_pull_close_match(struct sdf_pull_parser* p, size_t position, size_t end) {
+	size_t mark;	// where the open tag name starts
+
+	// trailing whitespaces are allowed
+	while(end > position + 2 && sdf_classes[(uint8_t)p->window[end - 1]] & SDF_MASK(SDF_SPACE))
+		end--;
+
+	if(p->depth == 0)
+		return 0;
+	mark = p->marks[p->depth - 1];
+
+	if(end - position - 2 != p->tags_length - mark)
+		return 0;
+
+	return !memcmp(p->window + position + 2, p->tags + mark, p->tags_length - mark);
+}
+
+// ---------------------------------------
+//
+// PUBLIC: SYNTAX CHECKER
+//
+// ---------------------------------------
+
+/**
+ * Check if the content of an sdf file is correct wrt syntax <>
+ * 
+ * [IN] struct sdf_file*: pointer to the struct to be filled
+ * [OUT] int: 1 if correct, 0 otherwise
+ */
+int syntax_check(struct sdf_file* file) {
+	long 				i;			// iterate over file buffer
+	enum parser_state	state;		// used to check current parser state
 
 	// reset parser state
 	state = BEGIN;
@@ -576,192 +1626,1135 @@ int syntax_check(struct sdf_file* file) {
 		}
 	}
 
-	return 1;
+	return 1;
+}
+
+// ---------------------------------------
+//
+// PRIVATE: WRITER BUFFER
+//
+// ---------------------------------------
+
+/**
+ * Write the whole buffer into the file and empty it
+ * 
+ * [IN] struct sdf_writer*: writer to be flushed
+ * [OUT] void
+ */
+void sdf_writer_flush(struct sdf_writer* w) {
+	size_t 	done = 0;	// bytes already written
+	ssize_t ret;		// bytes written by the last call
+
+	while(done < w->length && !w->error) {
+		ret = write(w->fd, w->buffer + done, w->length - done);
+		if(ret < 0)
+			w->error = 1;
+		else
+			done += ret;
+	}
+
+	w->length = 0;
+}
+
+/**
+ * Append n bytes to the buffer, flushing it when full
+ * 
+ * [IN] struct sdf_writer*: writer
+ * [IN] const char*: bytes to be written
+ * [IN] size_t: number of bytes
+ * [OUT] void
+ */
+void sdf_writer_put(struct sdf_writer* w, const char* data, size_t n) {
+	size_t chunk;	// bytes that fit into the buffer
+
+	while(n > 0) {
+		if(w->length == w->size && w->fd < 0) {
+			w->size *= 2;
+			w->buffer = sdf_realloc(w->buffer, w->size);
+		} else if(w->length == w->size) {
+			sdf_writer_flush(w);
+		}
+
+		chunk = w->size - w->length;
+		if(chunk > n)
+			chunk = n;
+
+		memcpy(w->buffer + w->length, data, chunk);
+		w->length += chunk;
+		data += chunk;
+		n -= chunk;
+	}
+}
+
+/**
+ * Append a number n of tabs to the buffer
+ * 
+ * [IN] struct sdf_writer*: writer
+ * [IN] int: number of tabs
+ * [OUT] void
+ */
+void sdf_writer_tabs(struct sdf_writer* w, int n) {
+	int chunk;	// tabs written by each put
+
+	if(w->compact)
+		return;
+
+	for(; n > 0; n -= chunk) {
+		chunk = n < (int)sizeof(SDF_WRITER_TABS) - 1 ? n : (int)sizeof(SDF_WRITER_TABS) - 1;
+		sdf_writer_put(w, SDF_WRITER_TABS, chunk);
+	}
+}
+
+/**
+ * Open a new element whose name is a string view. The view
+ * must stay valid until the element is closed
+ * 
+ * [IN] struct sdf_writer*: writer
+ * [IN] struct sdf_string*: tag name
+ * [OUT] void
+ */
+void sdf_writer_open_tag(struct sdf_writer* w, struct sdf_string* name) {
+	// terminate the start tag of the father
+	if(w->depth > 0 && w->state == WRITER_TAG)
+		sdf_writer_put(w, ">\n", 2);
+
+	// remember the name for the close tag
+	if(w->depth == w->tags_size) {
+		w->tags_size *= 2;
+		w->tags = sdf_realloc(w->tags, w->tags_size * sizeof(struct sdf_string));
+	}
+
+	sdf_writer_tabs(w, w->depth);
+	sdf_writer_put(w, "<", 1);
+	sdf_writer_put(w, name->buffer, name->length);
+
+	w->tags[w->depth++] = *name;
+	w->state = WRITER_TAG;
+}
+
+/**
+ * Add an attribute to the element just opened
+ * 
+ * [IN] struct sdf_writer*: writer
+ * [IN] const char*, size_t: attribute name and its length
+ * [IN] const char*, size_t: attribute value and its length
+ * [OUT] void
+ */
+void sdf_writer_put_attribute(struct sdf_writer* w, const char* name, size_t name_length,
+		const char* value, size_t value_length) {
+	sdf_writer_put(w, " ", 1);
+	sdf_writer_put(w, name, name_length);
+	sdf_writer_put(w, "=", 1);
+	sdf_writer_put(w, value, value_length);
+}
+
+/**
+ * Write the content of the element just opened
+ * 
+ * [IN] struct sdf_writer*: writer
+ * [IN] const char*, size_t: content and its length
+ * [OUT] void
+ */
+void sdf_writer_put_text(struct sdf_writer* w, const char* text, size_t length) {
+	sdf_writer_put(w, ">", 1);
+	sdf_writer_put(w, text, length);
+	w->state = WRITER_TEXT;
+}
+
+/**
+ * Search a string of a template into the overrides list
+ * 
+ * [IN] struct sdf_override*: overrides list (can be NULL)
+ * [IN] int: number of overrides
+ * [IN] struct sdf_string*: string of the template
+ * [OUT] char*: the new value or NULL if the string is not replaced
+ */
+char* sdf_override_search(struct sdf_override* overrides, int n, struct sdf_string* s) {
+	int i;
+
+	for(i = 0; i < n; i++)
+		if(overrides[i].target == s)
+			return overrides[i].value;
+
+	return NULL;
+}
+
+/**
+ * Open the element e of a template with its attributes
+ * 
+ * [IN] struct sdf_writer*: writer
+ * [IN] struct sdf_document*: document that contains e
+ * [IN] sdf_index: element to be opened
+ * [IN] struct sdf_override*: strings to be replaced (can be NULL)
+ * [IN] int: number of overrides
+ * [OUT] void
+ */
+void sdf_writer_template_tag(struct sdf_writer* w, struct sdf_document* d, sdf_index e,
+		struct sdf_override* overrides, int n) {
+	struct sdf_attribute* 	attr;
+	sdf_index 				a;
+	char* 					value;
+
+	sdf_writer_open_tag(w, &d->elements[e].name);
+
+	for(a = d->elements[e].attributes; a != SDF_NONE; a = attr->next) {
+		attr = d->attributes + a;
+		value = sdf_override_search(overrides, n, &attr->value);
+		if(value != NULL)
+			sdf_writer_put_attribute(w, attr->name.buffer, attr->name.length, value, strlen(value));
+		else
+			sdf_writer_put_attribute(w, attr->name.buffer, attr->name.length,
+				attr->value.buffer, attr->value.length);
+	}
+}
+
+// ---------------------------------------
+//
+// PRIVATE: PARALLEL PRINTER
+//
+// ---------------------------------------
+
+/**
+ * Prepare a writer that keeps the output in memory, as if
+ * depth elements were already open and had children
+ * 
+ * [IN] struct sdf_writer*: writer to be initialized
+ * [IN] int: number of elements already open
+ * [IN] int: 1 to write without indentation
+ * [OUT] void
+ */
+void sdf_writer_memory(struct sdf_writer* w, int depth, int compact) {
+	w->fd = -1;
+	w->buffer = alloc(SDF_WRITER_BUFFER, sizeof(char));
+	w->length = 0;
+	w->size = SDF_WRITER_BUFFER;
+	w->tags_size = depth + SDF_WRITER_TAGS;
+	w->tags = alloc(w->tags_size, sizeof(struct sdf_string));
+	w->depth = depth;
+	w->state = WRITER_CHILDREN;
+	w->compact = compact;
+	w->error = 0;
+}
+
+/**
+ * Write the buffers of n memory writers into the file of w,
+ * in order and with as few calls as possible. The memory
+ * writers are freed
+ * 
+ * [IN] struct sdf_writer*: writer of the file (flushed)
+ * [IN] struct sdf_writer*: memory writers
+ * [IN] uint32_t: number of memory writers
+ * [OUT] void
+ */
+void sdf_writer_gather(struct sdf_writer* w, struct sdf_writer* writers, uint32_t n) {
+	struct iovec* 	iov = alloc(n + 1, sizeof(struct iovec));
+	struct iovec* 	first = iov;		// first buffer not written yet
+	ssize_t 		ret;				// bytes written by the last call
+	uint32_t 		i;
+
+	for(i = 0; i < n; i++) {
+		iov[i].iov_base = writers[i].buffer;
+		iov[i].iov_len = writers[i].length;
+	}
+
+	while(n > 0 && !w->error) {
+		ret = writev(w->fd, first, n < SDF_WRITER_IOVECS ? n : SDF_WRITER_IOVECS);
+		if(ret < 0) {
+			w->error = 1;
+			break;
+		}
+
+		// drop the buffers written, a buffer can be written in part
+		for(; n > 0 && (size_t)ret >= first->iov_len; first++, n--)
+			ret -= first->iov_len;
+		if(n > 0) {
+			first->iov_base = (char*)first->iov_base + ret;
+			first->iov_len -= ret;
+		}
+	}
+
+	free(iov);
+}
+
+/**
+ * Worker of the parallel printer: format chunks of children
+ * into their own writers until all the chunks are taken
+ * 
+ * [IN] void*: the job (struct sdf_print_job*)
+ * [OUT] void*: NULL
+ */
+void* sdf_print_worker(void* arg) {
+	struct sdf_print_job* 	job = arg;
+	struct sdf_writer* 		w;
+	uint32_t 				i, c, first, last;
+
+	while((c = __atomic_fetch_add(&job->next, 1, __ATOMIC_RELAXED)) < job->n_chunks) {
+		w = job->writers + c;
+		sdf_writer_memory(w, job->depth, job->compact);
+
+		first = (uint64_t)c * job->n_children / job->n_chunks;
+		last = (uint64_t)(c + 1) * job->n_children / job->n_chunks;
+		for(i = first; i < last; i++)
+			sdf_writer_template(w, job->document, job->children[i], NULL, 0);
+	}
+
+	return NULL;
+}
+
+// ---------------------------------------
+//
+// PUBLIC: STRUCTURAL SCANNER
+//
+// ---------------------------------------
+
+/**
+ * Build the structural index of a buffer (first stage of the parser).
+ * The requested implementation is used if the cpu supports it,
+ * otherwise the best supported one is used
+ * 
+ * [IN] struct sdf_structure*: index to be filled
+ * [IN] char*: buffer to be indexed
+ * [IN] size_t: buffer length
+ * [IN] enum sdf_scanner: implementation to be used
+ * [OUT] enum sdf_scanner: implementation actually used
+ */
+enum sdf_scanner sdf_structure_build(struct sdf_structure* s, char* buffer, size_t length,
+		enum sdf_scanner scanner) {
+	void 	(*scan)(const char*, uint64_t*);	// block scanner
+	char 	tail[64];							// last (partial) block
+	size_t 	w;									// iterate over words
+
+	s->length = length;
+	s->words = (length + 63) / 64;
+	s->bits = alloc(s->words * SDF_CLASSES + 1, sizeof(uint64_t));
+
+	scanner = sdf_scanner_select(scanner);
+	switch(scanner) {
+#if defined(__x86_64__) || defined(__i386__)
+		case SDF_SCAN_AVX2:
+			scan = sdf_scan_block_avx2;
+			break;
+#endif
+#if defined(__SSE2__)
+		case SDF_SCAN_SSE2:
+			scan = sdf_scan_block_sse2;
+			break;
+#endif
+		default:
+			scan = sdf_scan_block_scalar;
+			break;
+	}
+
+	// full blocks are read in place
+	for(w = 0; w < length / 64; w++)
+		scan(buffer + w * 64, s->bits + w * SDF_CLASSES);
+
+	// the last block is padded with 0s (that belong to no class)
+	if(length % 64) {
+		memset(tail, 0, sizeof(tail));
+		memcpy(tail, buffer + w * 64, length % 64);
+		scan(tail, s->bits + w * SDF_CLASSES);
+	}
+
+	return scanner;
+}
+
+/**
+ * Find the first position, starting from position, that contains
+ * a character of one of the classes in mask (1 << enum sdf_class)
+ * 
+ * [IN] struct sdf_structure*: structural index
+ * [IN] size_t: first position to be checked
+ * [IN] unsigned: classes mask
+ * [OUT] size_t: position found or indexed buffer length
+ */
+size_t sdf_structure_next(struct sdf_structure* s, size_t position, unsigned mask) {
+	size_t 		word = position / 64;	// word that contains position
+	uint64_t 	bits;					// candidates in the current word
+
+	if(word >= s->words)
+		return s->length;
+
+	// ignore positions before the starting one
+	bits = sdf_structure_word(s, word, mask) & (~(uint64_t)0 << (position % 64));
+
+	while(bits == 0) {
+		if(++word == s->words)
+			return s->length;
+		bits = sdf_structure_word(s, word, mask);
+	}
+
+	return word * 64 + __builtin_ctzll(bits);
+}
+
+/**
+ * Free the memory allocated for the structural index
+ * 
+ * [IN] struct sdf_structure*: index to be freed
+ * [OUT] void
+ */
+void sdf_structure_free(struct sdf_structure* s) {
+	free(s->bits);
+	s->bits = NULL;
+	s->words = 0;
+}
+
+// ---------------------------------------
+//
+// PUBLIC: FILE METHODS
+//
+// ---------------------------------------
+
+/**
+ * Read the whole content of an opened file into a heap buffer.
+ * Used when the file can not be memory-mapped (e.g. pipes)
+ * 
+ * [IN] struct sdf_file*: pointer to the struct to be filled
+ * [IN] int: descriptor of the opened file
+ * [OUT] int: 0 if correct
+ */
+int sdf_file_read(struct sdf_file* file, int fd) {
+	size_t 	size = SDF_ARENA_BLOCK;	// allocated buffer size
+	ssize_t ret;					// bytes read by each call
+
+	file->buffer = alloc(size, sizeof(char));
+	file->length = 0;
+	file->mapped = 0;
+
+	// read until the end of file, keeping room for the terminator
+	while((ret = read(fd, file->buffer + file->length, size - file->length - 1)) != 0) {
+		if(ret < 0) {
+			free(file->buffer);
+			return -1;
+		}
+
+		file->length += ret;
+		if(file->length + 1 == size) {
+			size *= 2;
+			file->buffer = sdf_realloc(file->buffer, size);
+		}
+	}
+
+	// null-termine the content
+	file->buffer[file->length] = '\0';
+	return 0;
+}
+
+/**
+ * Map the whole content of an opened file in memory. One byte
+ * more than the file length is reserved (anonymous memory), so
+ * that the content is always 0-termined as in the heap version
+ * 
+ * [IN] struct sdf_file*: pointer to the struct to be filled
+ * [IN] int: descriptor of the opened file
+ * [OUT] int: 0 if correct
+ */
+int sdf_file_map(struct sdf_file* file, int fd) {
+	struct stat st;
+	char* 		area;
+
+	if(fstat(fd, &st) < 0 || !S_ISREG(st.st_mode))
+		return -1;
+
+	// reserve the area, the byte after the content will read as 0
+	area = mmap(NULL, st.st_size + 1, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if(area == MAP_FAILED)
+		return -1;
+
+	// place the file content at the beginning of the area
+	if(st.st_size > 0 && mmap(area, st.st_size, PROT_READ, 
+			MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+		munmap(area, st.st_size + 1);
+		return -1;
+	}
+
+	// the parser scans the file from the beginning to the end
+	madvise(area, st.st_size + 1, MADV_SEQUENTIAL);
+
+	file->buffer = area;
+	file->length = (size_t)st.st_size;
+	file->mapped = 1;
+	return 0;
+}
+
+/**
+ * Open an sdf file and make its content available into file structure.
+ * Regular files are memory-mapped, the others are read into memory
+ * 
+ * [IN] struct sdf_file*: pointer to the struct to be filled
+ * [IN] uint8_t const*: sdf filename * 	
+ * [OUT] int: 0 if correct
+ */
+int sdf_file_open(struct sdf_file* file, char const* filename) {
+	int fd;
+
+	// open the file in read mode
+	fd = open(filename, O_RDONLY);
+
+	// unable to open file
+	if(fd < 0)
+		return -1;
+
+	// map or read the file, the descriptor is not needed after that
+	if(sdf_file_map(file, fd) && sdf_file_read(file, fd)) {
+		close(fd);
+		return -1;
+	}
+	close(fd);
+
+	// fill structure information
+	file->filename = alloc(strlen(filename) + 1, sizeof(char));
+	strcpy(file->filename, filename);
+	return 0;
+}
+
+/**
+ * Delete the memory allocated for file structure
+ * 
+ * [IN] struct sdf_file*: pointer to the struct to be freed
+ * [OUT] void
+ */
+void sdf_file_close(struct sdf_file* file) {
+	free(file->filename);
+
+	if(file->mapped)
+		munmap(file->buffer, file->length + 1);
+	else
+		free(file->buffer);
+}
+
+// ---------------------------------------
+//
+// PUBLIC: DOCUMENT METHODS
+//
+// ---------------------------------------
+
+/**
+ * Initialize an empty SDF document (without root)
+ * 
+ * [IN] struct sdf_document*: document to be initialized
+ * [OUT] void
+ */
+void sdf_document_init(struct sdf_document* document) {
+	memset(document, 0, sizeof(struct sdf_document));
+	document->root = SDF_NONE;
+}
+
+/**
+ * Parse an SDF file and create a SDF document with
+ * element, attribute and so on. 
+ * 
+ * [IN] struct sdf_file*: pointer to sdf file to be analyzed
+ * [IN] struct sdf_document*: result will be lefe here
+ * [OUT] void
+ */
+void sdf_document_create(struct sdf_file* file, struct sdf_document* document) {
+	struct sdf_parser p; // represent the parser
+
+	// first stage: index the structural characters of the file
+	sdf_structure_build(&p.structure, file->buffer, file->length, SDF_SCAN_AUTO);
+
+	// second stage: run the state machine over the index until the file is finished
+	sdf_parser_start(&p, file, document, 0, file->length);
+	sdf_parser_run(&p);
+
+	sdf_structure_free(&p.structure);
+}
+
+/**
+ * Parse an SDF file with more threads. A prescan finds the children
+ * of the first element with more than one child (the models of a
+ * world), they are split into chunks and each chunk is parsed into
+ * its own document by a thread. The rest of the file is parsed as
+ * a skeleton and the chunks are moved under it. The tree is the same
+ * built by sdf_document_create, elements are stored in another order
+ * 
+ * [IN] struct sdf_file*: pointer to sdf file to be analyzed
+ * [IN] struct sdf_document*: result will be left here
+ * [IN] int: number of threads
+ * [OUT] void
+ */
+void sdf_document_create_parallel(struct sdf_file* file, struct sdf_document* document, int threads) {
+	struct sdf_parser 		p;			// parser of the skeleton
+	struct sdf_split_job 	job;		// chunks shared by the threads
+	struct sdf_span* 		spans;		// elements that can be split
+	struct sdf_chunk* 		c;
+	size_t 					n;
+	sdf_index 				n_elements, n_attributes;
+	sdf_atom 				a;
+	uint32_t 				i;
+
+	sdf_structure_build(&p.structure, file->buffer, file->length, SDF_SCAN_AUTO);
+	sdf_parser_start(&p, file, document, 0, file->length);
+
+	// nothing to split, parse on this thread
+	n = sdf_split_scan(&p.structure, file->buffer, &spans);
+	if(threads < 2 || n < 2) {
+		sdf_parser_run(&p);
+		sdf_structure_free(&p.structure);
+		free(spans);
+		return;
+	}
+
+	job.file = file;
+	job.structure = &p.structure;
+	job.document = document;
+	job.chunks = sdf_split_chunks(spans, n, threads * SDF_SPLIT_CHUNKS, &job.n_chunks);
+	free(spans);
+
+	// the skeleton leaves a placeholder for each chunk
+	p.chunks = job.chunks;
+	p.n_chunks = job.n_chunks;
+	sdf_parser_run(&p);
+	job.next = 0;
+	sdf_threads_run(sdf_parse_worker, &job, threads);
+
+	// reserve the indexes of each chunk and map its atoms
+	n_elements = document->n_elements;
+	n_attributes = document->n_attributes;
+	for(i = 0; i < job.n_chunks; i++) {
+		c = job.chunks + i;
+		c->elements = n_elements;
+		c->attributes = n_attributes;
+		n_elements += c->document.n_elements - 1;
+		n_attributes += c->document.n_attributes;
+
+		c->atoms = alloc(c->document.atoms.n_names + 1, sizeof(sdf_atom));
+		for(a = 0; a < c->document.atoms.n_names; a++)
+			c->atoms[a] = sdf_atom_intern(document, c->document.atoms.names + a);
+	}
+
+	if(n_elements > document->elements_size) {
+		document->elements_size = n_elements;
+		document->elements = sdf_realloc(document->elements, n_elements * sizeof(struct sdf_element));
+	}
+	if(n_attributes > document->attributes_size) {
+		document->attributes_size = n_attributes;
+		document->attributes = sdf_realloc(document->attributes, n_attributes * sizeof(struct sdf_attribute));
+	}
+	document->n_elements = n_elements;
+	document->n_attributes = n_attributes;
+
+	job.next = 0;
+	sdf_threads_run(sdf_stitch_worker, &job, threads);
+
+	free(job.chunks);
+	sdf_structure_free(&p.structure);
+}
+
+/**
+ * Print the root and its siblings with a writer
+ * 
+ * [IN] struct sdf_document*: pointer to SDF document to be printed
+ * [IN] char* filename: file in which print
+ * [IN] int: 1 to print without indentation
+ * [OUT] int: 0 if correct
+ */
+int sdf_document_write(struct sdf_document* d, char* filename, int compact) {
+	struct sdf_writer 	w;
+	sdf_index 			e;
+
+	// open the file in write mode or stdout
+	if(sdf_writer_open(&w, filename))
+		return -1;
+	w.compact = compact;
+
+	// print on file
+	for(e = d->root; e != SDF_NONE; e = d->elements[e].sibling)
+		sdf_writer_template(&w, d, e, NULL, 0);
+
+	// flush and close the file
+	return sdf_writer_close(&w);
+}
+
+/**
+ * Print the document with more threads. The children of the first
+ * element with more than one child (the models of a world) are
+ * split into chunks, each chunk is formatted into its own buffer
+ * by a thread and the buffers are written in order with writev.
+ * The output is the same written by sdf_document_write
+ * 
+ * [IN] struct sdf_document*: pointer to SDF document to be printed
+ * [IN] char* filename: file in which print
+ * [IN] int: 1 to print without indentation
+ * [IN] int: number of threads
+ * [OUT] int: 0 if correct
+ */
+int sdf_document_write_parallel(struct sdf_document* d, char* filename, int compact, int threads) {
+	struct sdf_writer 		w;
+	struct sdf_print_job 	job;
+	sdf_index* 				path;		// elements opened before the children
+	sdf_index 				father = SDF_NONE, first = d->root, e;
+	int 					depth = 0, i;
+	uint32_t 				c;
+
+	// go down through only children (an element with content shows no children)
+	while(first != SDF_NONE && d->elements[first].sibling == SDF_NONE
+			&& d->elements[first].content.buffer == NULL) {
+		father = first;
+		first = d->elements[first].children;
+		depth++;
+	}
+
+	// nothing to split, print on this thread
+	if(threads < 2 || first == SDF_NONE || d->elements[first].sibling == SDF_NONE)
+		return sdf_document_write(d, filename, compact);
+
+	if(sdf_writer_open(&w, filename))
+		return -1;
+	w.compact = compact;
+
+	// open the fathers of the children, from the root
+	path = alloc(depth + 1, sizeof(sdf_index));
+	for(i = depth - 1, e = father; i >= 0; i--, e = d->elements[e].father)
+		path[i] = e;
+	for(i = 0; i < depth; i++)
+		sdf_writer_template_open(&w, d, path[i]);
+	free(path);
+	if(depth > 0) {
+		sdf_writer_put(&w, ">\n", 2);
+		w.state = WRITER_CHILDREN;
+	}
+	sdf_writer_flush(&w);
+
+	// list the children and format them in chunks
+	job.document = d;
+	job.n_children = 0;
+	for(e = first; e != SDF_NONE; e = d->elements[e].sibling)
+		job.n_children++;
+	job.children = alloc(job.n_children, sizeof(sdf_index));
+	for(e = first, c = 0; e != SDF_NONE; e = d->elements[e].sibling)
+		job.children[c++] = e;
+
+	job.n_chunks = threads * SDF_SPLIT_CHUNKS;
+	if(job.n_chunks > job.n_children)
+		job.n_chunks = job.n_children;
+	job.writers = alloc(job.n_chunks, sizeof(struct sdf_writer));
+	job.depth = depth;
+	job.compact = compact;
+	job.next = 0;
+	sdf_threads_run(sdf_print_worker, &job, threads);
+
+	// write the chunks in order
+	sdf_writer_gather(&w, job.writers, job.n_chunks);
+	for(c = 0; c < job.n_chunks; c++) {
+		free(job.writers[c].buffer);
+		free(job.writers[c].tags);
+	}
+	free(job.writers);
+	free(job.children);
+
+	// close the fathers
+	return sdf_writer_close(&w);
+}
+
+/**
+ * Print the entire document into a file. Pass NULL to print
+ * in the terminal
+ * 
+ * [IN] struct sdf_document*: pointer to SDF document to be printed
+ * [IN] char* filename: file in which print
+ * [OUT] int: 0 if correct
+ */
+int sdf_document_print(struct sdf_document* d, char* filename) {
+	return sdf_document_write(d, filename, 0);
+}
+
+/**
+ * Print the entire document into a file without indentation.
+ * Pass NULL to print in the terminal
+ * 
+ * [IN] struct sdf_document*: pointer to SDF document to be printed
+ * [IN] char* filename: file in which print
+ * [OUT] int: 0 if correct
+ */
+int sdf_document_print_compact(struct sdf_document* d, char* filename) {
+	return sdf_document_write(d, filename, 1);
+}
+
+/**
+ * Print the entire document into a file with more threads.
+ * Pass NULL to print in the terminal
+ * 
+ * [IN] struct sdf_document*: pointer to SDF document to be printed
+ * [IN] char* filename: file in which print
+ * [IN] int: number of threads
+ * [OUT] int: 0 if correct
+ */
+int sdf_document_print_parallel(struct sdf_document* d, char* filename, int threads) {
+	return sdf_document_write_parallel(d, filename, 0, threads);
+}
+
+/**
+ * Close an SDF document and frees the allocated memory.
+ * Nodes and strings are released in blocks, without
+ * visiting the tree
+ * 
+ * [IN] struct sdf_document*: pointer to SDF document to be cancelled
+ * [OUT] void
+ */
+void sdf_document_close(struct sdf_document* document) {
+	free(document->elements);
+	free(document->attributes);
+	free(document->atoms.names);
+	free(document->atoms.table);
+	sdf_arena_free(&document->arena);
+	sdf_document_init(document);
 }
 
 // ---------------------------------------
 //
-// PRIVATE: STRING PRINTER
+// PUBLIC: PULL PARSER METHODS
 //
 // ---------------------------------------
 
 /**
- * Print into file F attribute list specified
+ * Initialize a pull parser. The window must be larger than
+ * the largest tag (or content) of the input
  * 
- * [IN] struct sdf_attribute*: pointer to the struct that contains attribute
- * [OUT] FILE* f: 1 if correct, 0 otherwise
+ * [IN] struct sdf_pull_parser*: parser to be initialized
+ * [IN] size_t: window size in bytes (0 for the default one)
+ * [OUT] void
  */
-void sdf_attribute_print(struct sdf_attribute* attr, FILE* f) {
-	if(attr == NULL)
-		return;
+void sdf_parser_init(struct sdf_pull_parser* p, size_t window) {
+	memset(p, 0, sizeof(struct sdf_pull_parser));
+	p->size = window > 0 ? window : SDF_PULL_WINDOW;
+	p->window = alloc(p->size, sizeof(char));
+	p->attributes_size = SDF_PULL_ATTRIBUTES;
+	p->attributes = alloc(p->attributes_size, sizeof(struct sdf_attribute));
+	p->tags_size = SDF_PULL_NAMES;
+	p->tags = alloc(p->tags_size, sizeof(char));
+	p->marks_size = SDF_PULL_TAGS;
+	p->marks = alloc(p->marks_size, sizeof(size_t));
+	p->state = PULL_TAGS;
+}
+
+/**
+ * Feed the next chunk of input. The bytes already consumed are
+ * dropped and as many bytes as fit into the window are copied,
+ * the rest must be fed again after the events have been read.
+ * Feed a chunk of length 0 at the end of input
+ * 
+ * [IN] struct sdf_pull_parser*: parser
+ * [IN] const char*: chunk of input
+ * [IN] size_t: chunk length (0 at the end of input)
+ * [OUT] size_t: bytes of the chunk copied into the window
+ */
+size_t sdf_parser_feed(struct sdf_pull_parser* p, const char* buffer, size_t length) {
+	if(length == 0) {
+		p->last = 1;
+		return 0;
+	}
+
+	// move the tag that is being parsed at the beginning of the window
+	if(p->start > 0) {
+		memmove(p->window, p->window + p->start, p->length - p->start);
+		p->length -= p->start;
+		p->start = 0;
+	}
 
-	fprintf(f, " %s=%s", attr->name->buffer, attr->value->buffer);
-	sdf_attribute_print(attr->next, f);
+	if(length > p->size - p->length)
+		length = p->size - p->length;
+	memcpy(p->window + p->length, buffer, length);
+	p->length += length;
+
+	return length;
 }
 
 /**
- * Print into file F the element specified
+ * Parse the next event. Name, content and attributes of the event
+ * are left into the parser. SDF_EVENT_NONE is returned when the
+ * window does not hold the whole next tag, then more input must
+ * be fed. END and ERROR are returned again by the next calls
  * 
- * [IN] struct sdf_element*: pointer to the element that must be printed
- * [IN] int: number of tabs for this element (pretty print)
- * [IN] FILE*: pointer to the file in which print
- * [OUT] void
+ * [IN] struct sdf_pull_parser*: parser
+ * [OUT] enum sdf_event: the event
  */
-void sdf_element_print(struct sdf_element* e, int tab_level, FILE* f) {
-	// print tabs and tag name
-	print_tabs(tab_level, f);
-	fprintf(f, "<%s", e->name->buffer);
-	sdf_attribute_print(e->attributes, f);
-	
-	// print the correct open/close pair
-	if(e->content != NULL) {
-		fprintf(f, ">%s</%s>\n", e->content->buffer, e->name->buffer);
-	} else if(e->children != NULL) {
-		fprintf(f, ">\n");
-		sdf_element_print(e->children, tab_level+1, f);
-		print_tabs(tab_level, f);
-		fprintf(f, "</%s>\n", e->name->buffer);
-	} else {
-		fprintf(f, "/>\n");
+enum sdf_event sdf_parser_next_event(struct sdf_pull_parser* p) {
+	char* 	b = p->window;
+	size_t 	lt, gt;		// < and > of the next tag
+	size_t 	end;		// end of a comment or declaration
+	int 	self;		// 1 for a self-close tag
+
+	switch(p->state) {
+		case PULL_END:
+			return SDF_EVENT_END;
+		case PULL_ERROR:
+			return SDF_EVENT_ERROR;
+		case PULL_SELF_CLOSED:
+			sdf_pull_pop(p);
+			p->state = PULL_TAGS;
+			return SDF_EVENT_CLOSE;
+		default:
+			break;
+	}
+
+	while(1) {
+		// the next tag and the character after < are needed
+		lt = sdf_pull_find(p, p->start, '<');
+		if(lt == p->length && p->last) {
+			if(p->depth > 0)
+				return sdf_pull_error(p, "unexpected end of input");
+			p->state = PULL_END;
+			return SDF_EVENT_END;
+		}
+		if(lt + 1 >= p->length) {
+			// text between tags is not kept
+			if(p->state != PULL_OPENED)
+				p->start = lt;
+			return sdf_pull_more(p);
+		}
+
+		// the text before a close tag is the content of the tag just opened
+		if(p->state == PULL_OPENED && b[lt + 1] == '/') {
+			p->content.buffer = b + p->start;
+			p->content.length = lt - p->start;
+			p->start = lt;
+			p->state = PULL_TAGS;
+			return SDF_EVENT_CONTENT;
+		}
+		p->start = lt;
+		p->state = PULL_TAGS;
+
+		// comments <!-- .. --> and declarations <! ..> <? ..?> are skipped
+		if(b[lt + 1] == '!' || b[lt + 1] == '?') {
+			if(p->length - lt < 4)
+				return sdf_pull_more(p);
+			if(b[lt + 1] == '?')
+				end = sdf_pull_find_string(p, lt + 2, "?>") + 2;
+			else if(!memcmp(b + lt, "<!--", 4))
+				end = sdf_pull_find_string(p, lt + 4, "-->") + 3;
+			else
+				end = sdf_pull_find(p, lt + 2, '>') + 1;
+			if(end > p->length)
+				return sdf_pull_more(p);
+			p->start = end;
+			continue;
+		}
+
+		// close tag </tag>
+		if(b[lt + 1] == '/') {
+			gt = sdf_pull_find(p, lt + 2, '>');
+			if(gt == p->length)
+				return sdf_pull_more(p);
+			if(!sdf_pull_close_match(p, lt, gt))
+				return sdf_pull_error(p, "close tag does not follow its open tag");
+			sdf_pull_pop(p);
+			p->start = gt + 1;
+			return SDF_EVENT_CLOSE;
+		}
+
+		// open tag <tag ..> or <tag ../>
+		gt = sdf_pull_tag_end(p, lt + 1);
+		if(gt == p->length)
+			return sdf_pull_more(p);
+		self = b[gt - 1] == '/';
+		if(sdf_pull_tag_extract(p, lt, self ? gt - 1 : gt))
+			return sdf_pull_error(p, "tag not valid");
+		sdf_pull_push(p, &p->name);
+		p->start = gt + 1;
+		p->state = self ? PULL_SELF_CLOSED : PULL_OPENED;
+		return SDF_EVENT_OPEN;
 	}
+}
 
-	// print also siblings
-	if(e->sibling != NULL)
-		sdf_element_print(e->sibling, tab_level, f);		
+/**
+ * Free the memory allocated for a pull parser
+ * 
+ * [IN] struct sdf_pull_parser*: parser to be freed
+ * [OUT] void
+ */
+void sdf_parser_close(struct sdf_pull_parser* p) {
+	free(p->window);
+	free(p->attributes);
+	free(p->tags);
+	free(p->marks);
+	memset(p, 0, sizeof(struct sdf_pull_parser));
 }
 
 // ---------------------------------------
 //
-// PUBLIC: FILE METHODS
+// PUBLIC: WRITER METHODS
 //
 // ---------------------------------------
 
 /**
- * Open an sdf file and copy the content into file structure
+ * Open a file and prepare the writer. Pass NULL to write
+ * in the terminal
  * 
- * [IN] struct sdf_file*: pointer to the struct to be filled
- * [IN] uint8_t const*: sdf filename * 	
+ * [IN] struct sdf_writer*: writer to be initialized
+ * [IN] char*: name of the file in which write
  * [OUT] int: 0 if correct
  */
-int sdf_file_open(struct sdf_file* file, char const* filename) {
-	FILE* 	sdf_input;
-	long 	file_size;
-
-	// open the file in read mode
-	sdf_input = fopen(filename, "r");
+int sdf_writer_open(struct sdf_writer* w, char* filename) {
+	// open the file in write mode or stdout
+	if(filename == NULL)
+		w->fd = STDOUT_FILENO;
+	else
+		w->fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
 
 	// unable to open file
-	if(sdf_input == NULL)
+	if(w->fd < 0)
 		return -1;
 
-	// get file size
-	file_size = get_file_size(sdf_input);
-
-	// fill structure information
-	file->filename = alloc(strlen(filename), sizeof(char));
-	file->length = (size_t)file_size;
-	file->buffer = alloc(file_size + 1, sizeof(char));
-	
-	// copy file content into buffer and null-termine it
-	strcpy(file->filename, filename);
-	fread(file->buffer, file_size, 1, sdf_input);
-	file->buffer[file_size] = '\0';
-	
-	// close the file
-	fclose(sdf_input);
+	w->buffer = alloc(SDF_WRITER_BUFFER, sizeof(char));
+	w->length = 0;
+	w->size = SDF_WRITER_BUFFER;
+	w->tags = alloc(SDF_WRITER_TAGS, sizeof(struct sdf_string));
+	w->depth = 0;
+	w->tags_size = SDF_WRITER_TAGS;
+	w->state = WRITER_CHILDREN;
+	w->compact = 0;
+	w->error = 0;
 	return 0;
 }
 
 /**
- * Delete the memory allocated for file structure
+ * Close all the elements still open, flush the buffer
+ * and close the file
  * 
- * [IN] struct sdf_file*: pointer to the struct to be freed
- * [OUT] void
+ * [IN] struct sdf_writer*: writer to be closed
+ * [OUT] int: 0 if everything was written
  */
-void sdf_file_close(struct sdf_file* file) {
-	free(file->buffer);
-}
+int sdf_writer_close(struct sdf_writer* w) {
+	while(w->depth > 0)
+		sdf_writer_element_close(w);
 
-// ---------------------------------------
-//
-// PUBLIC: DOCUMENT METHODS
-//
-// ---------------------------------------
+	sdf_writer_flush(w);
+	if(w->fd != STDOUT_FILENO && close(w->fd) < 0)
+		w->error = 1;
+
+	free(w->buffer);
+	free(w->tags);
+	return w->error ? -1 : 0;
+}
 
 /**
- * Parse an SDF file and create a SDF document with
- * element, attribute and so on. 
+ * Open a new element, child of the innermost open one.
+ * The name must stay valid until the element is closed
  * 
- * [IN] struct sdf_file*: pointer to sdf file to be analyzed
- * [IN] struct sdf_document*: result will be lefe here
+ * [IN] struct sdf_writer*: writer
+ * [IN] char*: tag name (must be 0-termined)
  * [OUT] void
  */
-void sdf_document_create(struct sdf_file* file, struct sdf_document* document) {
-	struct sdf_parser p; // represent the parser
+void sdf_writer_element_open(struct sdf_writer* w, char* name) {
+	struct sdf_string s;
 
-	// allocate the document internal struct and check for memory problem
-	document->root = alloc(1, sizeof(struct sdf_element));
+	s.buffer = name;
+	s.length = strlen(name);
+	sdf_writer_open_tag(w, &s);
+}
 
-	// initialize parser
-	p.file = file;
-	p.position = 0;
-	p.state = BEGIN;
-	p.elem = document->root;
-	list_init(&p.l);
+/**
+ * Add an attribute to the element just opened
+ * 
+ * [IN] struct sdf_writer*: writer
+ * [IN] char*: attribute name (must be 0-termined)
+ * [IN] char*: attribute value, quotes included (must be 0-termined)
+ * [OUT] void
+ */
+void sdf_writer_attribute(struct sdf_writer* w, char* name, char* value) {
+	sdf_writer_put_attribute(w, name, strlen(name), value, strlen(value));
+}
 
-	// until the file is not finished
-	while(p.position < p.file->length) {
-		if(!strncmp(p.file->buffer+p.position, "<!", 2))
-			sdf_comment_tag(&p);
-		else if(!strncmp(p.file->buffer+p.position, "</", 2))
-			sdf_close_tag(&p);
-		else if(!strncmp(p.file->buffer+p.position, "/>", 2))
-			sdf_self_close_tag(&p);
-		else if(!strncmp(p.file->buffer+p.position, ">", 1))
-			sdf_new_tag_close(&p);
-		else if(!strncmp(p.file->buffer+p.position, "<", 1))
-			sdf_new_tag_open(&p);
-	}
+/**
+ * Write the content of the element just opened
+ * 
+ * [IN] struct sdf_writer*: writer
+ * [IN] char*: tag content (must be 0-termined)
+ * [OUT] void
+ */
+void sdf_writer_text(struct sdf_writer* w, char* text) {
+	sdf_writer_put_text(w, text, strlen(text));
 }
 
 /**
- * Print the entire document into a file. Pass NULL to print
- * in the terminal
+ * Close the innermost open element
  * 
- * [IN] struct sdf_document*: pointer to SDF document to be printed
- * [IN] char* filename: file in which print
+ * [IN] struct sdf_writer*: writer
  * [OUT] void
  */
-int sdf_document_print(struct sdf_document* d, char* filename) {
-	FILE* 	sdf_output;
+void sdf_writer_element_close(struct sdf_writer* w) {
+	struct sdf_string* name;
 
-	// open the file in read mode or stdout
-	if(filename == NULL)
-		sdf_output = stdout;
-	else
-		sdf_output = fopen(filename, "w");
+	if(w->depth == 0)
+		return;
 
-	// unable to open file
-	if(sdf_output == NULL)
-		return -1;
-	
-	// print on file
-	sdf_element_print(d->root, 0, sdf_output);
-	
-	// close the file
-	fclose(sdf_output);
+	name = w->tags + --w->depth;
 
-	return 0;
+	// print the correct close tag
+	if(w->state == WRITER_TAG) {
+		sdf_writer_put(w, "/>\n", 3);
+	} else {
+		if(w->state == WRITER_CHILDREN)
+			sdf_writer_tabs(w, w->depth);
+		sdf_writer_put(w, "</", 2);
+		sdf_writer_put(w, name->buffer, name->length);
+		sdf_writer_put(w, ">\n", 2);
+	}
+
+	// the father has at least this child
+	w->state = WRITER_CHILDREN;
 }
 
 /**
- * Close an SDF document and frees the allocated memory
+ * Open a new element copying name and attributes of the element e
+ * of a document. Children of e are not written
  * 
- * [IN] struct sdf_document*: pointer to SDF document to be cancelled
+ * [IN] struct sdf_writer*: writer
+ * [IN] struct sdf_document*: document that contains e
+ * [IN] sdf_index: element to be copied
  * [OUT] void
  */
-void sdf_document_close(struct sdf_document* document) {
-	sdf_element_close(document->root);
+void sdf_writer_template_open(struct sdf_writer* w, struct sdf_document* d, sdf_index e) {
+	sdf_writer_template_tag(w, d, e, NULL, 0);
+}
+
+/**
+ * Write the element e of a document with its attributes and its
+ * children. Strings listed in the overrides are replaced by the
+ * new values, the document is not modified
+ * 
+ * [IN] struct sdf_writer*: writer
+ * [IN] struct sdf_document*: document that contains e
+ * [IN] sdf_index: element to be written
+ * [IN] struct sdf_override*: strings to be replaced (can be NULL)
+ * [IN] int: number of overrides
+ * [OUT] void
+ */
+void sdf_writer_template(struct sdf_writer* w, struct sdf_document* d, sdf_index e,
+		struct sdf_override* overrides, int n) {
+	struct sdf_element* elem;
+	sdf_index 			i = e;		// element that is written
+	char* 				content;
+
+	while(1) {
+		elem = d->elements + i;
+		sdf_writer_template_tag(w, d, i, overrides, n);
+
+		// write the content or go down to the children
+		if(elem->content.buffer != NULL) {
+			content = sdf_override_search(overrides, n, &elem->content);
+			if(content != NULL)
+				sdf_writer_put_text(w, content, strlen(content));
+			else
+				sdf_writer_put_text(w, elem->content.buffer, elem->content.length);
+		} else if(elem->children != SDF_NONE) {
+			i = elem->children;
+			continue;
+		}
+
+		// close the element and the fathers left without siblings
+		sdf_writer_element_close(w);
+		while(i != e && d->elements[i].sibling == SDF_NONE) {
+			i = d->elements[i].father;
+			sdf_writer_element_close(w);
+		}
+
+		if(i == e)
+			return;
+		i = d->elements[i].sibling;
+	}
 }
 
 // ---------------------------------------
@@ -770,66 +2763,110 @@ void sdf_document_close(struct sdf_document* document) {
 //
 // ---------------------------------------
 
+/**
+ * Get the element stored at index e. The pointer is valid
+ * until a new element is added to the document
+ * 
+ * [IN] struct sdf_document*: document that contains the element
+ * [IN] sdf_index: index of the element
+ * [OUT] struct sdf_element*: pointer to the element struct
+ */
+struct sdf_element* sdf_element_get(struct sdf_document* d, sdf_index e) {
+	return d->elements + e;
+}
+
+/**
+ * Get the attribute stored at index a. The pointer is valid
+ * until a new attribute is added to the document
+ * 
+ * [IN] struct sdf_document*: document that contains the attribute
+ * [IN] sdf_index: index of the attribute
+ * [OUT] struct sdf_attribute*: pointer to the attribute struct
+ */
+struct sdf_attribute* sdf_attribute_get(struct sdf_document* d, sdf_index a) {
+	return d->attributes + a;
+}
+
 /**
  * Search a tag into an element e. Privilege children node
  * 
- * [IN] struct sdf_element*: pointer to SDF element in which operate search
+ * [IN] struct sdf_document*: document that contains the element
+ * [IN] sdf_index: SDF element in which operate search
  * [IN] char*: name of tag that must be searched
- * [OUT] void
+ * [OUT] sdf_index: index of the element or SDF_NONE
  */
-struct sdf_element* sdf_element_deep_search(struct sdf_element* e, char* tag_name) {
-	struct sdf_element *tag;
+sdf_index sdf_element_deep_search(struct sdf_document* d, sdf_index e, char* tag_name) {
+	sdf_atom 	atom = sdf_atom_find(d, tag_name);
+	sdf_index 	stop;		// father of e, the search never goes up to it
 
-	if(e == NULL)
-		return NULL;
-	
-	if(!strcmp(e->name->buffer, tag_name))
-		return e;
-	
-	tag = sdf_element_search(e->children, tag_name);
-	if(tag != NULL)
-		return tag;
-	
-	tag = sdf_element_search(e->sibling, tag_name);
-	if(tag != NULL)
-		return tag;
+	if(e == SDF_NONE || atom == SDF_NO_ATOM)
+		return SDF_NONE;
+	stop = d->elements[e].father;
 
-	// not found
-	return NULL;
+	while(1) {
+		if(d->elements[e].atom == atom)
+			return e;
+
+		// children before siblings
+		if(d->elements[e].children != SDF_NONE) {
+			e = d->elements[e].children;
+			continue;
+		}
+
+		// go up to the first father that has a sibling
+		while(d->elements[e].sibling == SDF_NONE) {
+			e = d->elements[e].father;
+			if(e == stop)
+				return SDF_NONE;
+		}
+		e = d->elements[e].sibling;
+	}
 }
 
 /**
  * Search a tag into an element e. Avoid children nodes
  * 
- * [IN] struct sdf_element*: pointer to SDF element in which operate search
+ * [IN] struct sdf_document*: document that contains the element
+ * [IN] sdf_index: SDF element in which operate search
  * [IN] char*: name of tag that must be searched
- * [OUT] void
+ * [OUT] sdf_index: index of the element or SDF_NONE
  */
-struct sdf_element* sdf_element_search(struct sdf_element* e, char* tag_name) {
-	struct sdf_element* tag;
+sdf_index sdf_element_search(struct sdf_document* d, sdf_index e, char* tag_name) {
+	sdf_atom atom = sdf_atom_find(d, tag_name);
 
-	if(e == NULL)
-		return NULL;
-	
-	if(!strcmp(e->name->buffer, tag_name))
-		return e;
-	
-	tag = sdf_element_search(e->sibling, tag_name);
-	if(tag != NULL)
-		return tag;
+	// a name never seen can't be found
+	if(atom == SDF_NO_ATOM)
+		return SDF_NONE;
+
+	for(; e != SDF_NONE; e = d->elements[e].sibling)
+		if(d->elements[e].atom == atom)
+			return e;
 
 	// not found
-	return NULL;
+	return SDF_NONE;
 }
 
-struct sdf_attribute* sdf_attribute_search(struct sdf_attribute* a, char* attr_name) {
-	if(a == NULL)
-		return NULL;
+/**
+ * Search an attribute into an attribute list a
+ * 
+ * [IN] struct sdf_document*: document that contains the list
+ * [IN] sdf_index: SDF attribute list in which operate search
+ * [IN] char*: name of the attribute that must be searched
+ * [OUT] sdf_index: index of the attribute or SDF_NONE
+ */
+sdf_index sdf_attribute_search(struct sdf_document* d, sdf_index a, char* attr_name) {
+	sdf_atom atom = sdf_atom_find(d, attr_name);
 
-	if(!strcmp(a->name->buffer, attr_name))
-		return a;
-	
-	return sdf_attribute_search(a->next, attr_name);
+	// a name never seen can't be found
+	if(atom == SDF_NO_ATOM)
+		return SDF_NONE;
+
+	for(; a != SDF_NONE; a = d->attributes[a].next)
+		if(d->attributes[a].atom == atom)
+			return a;
+
+	// not found
+	return SDF_NONE;
 }
 
 // ---------------------------------------
@@ -839,31 +2876,328 @@ struct sdf_attribute* sdf_attribute_search(struct sdf_attribute* a, char* attr_n
 // ---------------------------------------
 
 /**
- * Append the element e to sibling as sibling
+ * Append the element e to father as children
  * 
- * [IN] struct sdf_element**: pointer to SDF element in which append e
- * [IN] struct sdf_element*: element taht that must be appended
+ * [IN] struct sdf_document*: document that contains both elements
+ * [IN] sdf_index: SDF element in which append e
+ * [IN] sdf_index: element that must be appended
  * [OUT] void
  */
-void sdf_element_append_sibling(struct sdf_element** sibling, struct sdf_element* e) {
-	if((*sibling)->sibling == NULL)
-		(*sibling)->sibling = e;
+void sdf_element_append(struct sdf_document* d, sdf_index father, sdf_index e) {
+	struct sdf_element* f = d->elements + father;
+
+	d->elements[e].father = father;
+
+	// link after the last child, no need to walk the siblings
+	if(f->last_child != SDF_NONE)
+		d->elements[f->last_child].sibling = e;
 	else
-		sdf_element_append_sibling(&(*sibling)->sibling, e);
+		f->children = e;
+	f->last_child = e;
 }
 
+// ---------------------------------------
+//
+// PUBLIC: CLONE ELEMENT
+//
+// ---------------------------------------
+
 /**
- * Append the element e to father as children
+ * Copy a string of the document src into the arena of dst
  * 
- * [IN] struct sdf_element**: pointer to SDF element in which append e
- * [IN] struct sdf_element*: element that must be appended
+ * [IN] struct sdf_document*: document that will own the copy
+ * [IN] struct sdf_string*: copy will be left here
+ * [IN] struct sdf_string*: string that must be copied
  * [OUT] void
  */
-void sdf_element_append(struct sdf_element** father, struct sdf_element* e) {
-	if((*father)->children != NULL)
-		sdf_element_append_sibling(&(*father)->children, e);
-	else
-		(*father)->children = e;
+void sdf_string_clone(struct sdf_document* dst, struct sdf_string* copy, struct sdf_string* s) {
+	if(s->buffer == NULL) {
+		copy->buffer = NULL;
+		copy->length = 0;
+	} else {
+		sdf_string_set(dst, copy, s->buffer, s->length);
+	}
+}
+
+/**
+ * Copy an attribute list into the document dst, keeping the same order
+ * 
+ * [IN] struct sdf_document*: document in which create the copy
+ * [IN] struct sdf_document*: document that contains the list
+ * [IN] sdf_index: list that must be copied (can be SDF_NONE)
+ * [OUT] sdf_index: the new list or SDF_NONE
+ */
+sdf_index sdf_attribute_clone(struct sdf_document* dst, struct sdf_document* src, sdf_index a) {
+	sdf_index 	head = SDF_NONE;	// head of the new list
+	sdf_index 	tail = SDF_NONE;	// last copy in the new list
+	sdf_index 	copy;				// new attribute
+
+	for(; a != SDF_NONE; a = src->attributes[a].next) {
+		copy = sdf_attribute_new(dst);
+		sdf_string_clone(dst, &dst->attributes[copy].name, &src->attributes[a].name);
+		sdf_string_clone(dst, &dst->attributes[copy].value, &src->attributes[a].value);
+		dst->attributes[copy].atom = sdf_atom_intern(dst, &dst->attributes[copy].name);
+
+		if(tail == SDF_NONE)
+			head = copy;
+		else
+			dst->attributes[tail].next = copy;
+		tail = copy;
+	}
+
+	return head;
+}
+
+/**
+ * Create a deep copy of the element e, its attributes and its children,
+ * into the document dst (that can be the same of src).
+ * Siblings of e are not copied and the copy has no father.
+ * 
+ * [IN] struct sdf_document*: document in which create the copy
+ * [IN] struct sdf_document*: document that contains e
+ * [IN] sdf_index: element that must be copied
+ * [OUT] sdf_index: the new element
+ */
+sdf_index sdf_element_clone(struct sdf_document* dst, struct sdf_document* src, sdf_index e) {
+	sdf_index 	i = e;				// element of src that is copied
+	sdf_index 	copy;				// copy of i
+	sdf_index 	root = SDF_NONE;	// copy of e
+	sdf_index 	father = SDF_NONE;	// copy of the father of i
+
+	while(1) {
+		copy = sdf_element_new(dst);
+		sdf_string_clone(dst, &dst->elements[copy].name, &src->elements[i].name);
+		sdf_string_clone(dst, &dst->elements[copy].content, &src->elements[i].content);
+		dst->elements[copy].atom = sdf_atom_intern(dst, &dst->elements[copy].name);
+		dst->elements[copy].attributes = sdf_attribute_clone(dst, src, src->elements[i].attributes);
+
+		if(root == SDF_NONE)
+			root = copy;
+		else
+			sdf_element_append(dst, father, copy);
+
+		// copy the children before the siblings
+		if(src->elements[i].children != SDF_NONE) {
+			father = copy;
+			i = src->elements[i].children;
+			continue;
+		}
+
+		// go up to the first father that has a sibling
+		while(i != e && src->elements[i].sibling == SDF_NONE) {
+			i = src->elements[i].father;
+			father = dst->elements[father].father;
+		}
+
+		if(i == e)
+			return root;
+		i = src->elements[i].sibling;
+	}
+}
+
+// ---------------------------------------
+//
+// PUBLIC: ATOMS AND QUERIES
+//
+// ---------------------------------------
+
+/**
+ * Intern a name into the atom table of a document. The name
+ * must stay valid while the document is in use
+ * 
+ * [IN] struct sdf_document*: document that owns the table
+ * [IN] struct sdf_string*: name to be interned
+ * [OUT] sdf_atom: atom of the name
+ */
+sdf_atom sdf_atom_intern(struct sdf_document* d, struct sdf_string* name) {
+	struct sdf_atoms* 	t = &d->atoms;
+	sdf_atom* 			slot;
+
+	if(name->buffer == NULL)
+		return SDF_NO_ATOM;
+
+	// keep the table at most half full
+	if(2 * (t->n_names + 1) > (t->table ? t->mask + 1 : 0))
+		sdf_atom_grow(t);
+
+	slot = sdf_atom_slot(t, name->buffer, name->length);
+	if(*slot != SDF_NO_ATOM)
+		return *slot;
+
+	// a new name
+	if(t->n_names == t->names_size) {
+		t->names_size = t->names_size ? t->names_size * 2 : SDF_ARRAY_SIZE;
+		t->names = sdf_realloc(t->names, t->names_size * sizeof(struct sdf_string));
+	}
+	t->names[t->n_names] = *name;
+	*slot = t->n_names;
+
+	return t->n_names++;
+}
+
+/**
+ * Find the atom of a name, without adding it
+ * 
+ * [IN] struct sdf_document*: document that owns the table
+ * [IN] char*: name (must be 0-termined)
+ * [OUT] sdf_atom: atom of the name or SDF_NO_ATOM
+ */
+sdf_atom sdf_atom_find(struct sdf_document* d, char* name) {
+	if(d->atoms.table == NULL)
+		return SDF_NO_ATOM;
+
+	return *sdf_atom_slot(&d->atoms, name, strlen(name));
+}
+
+/**
+ * Compile a query path made of steps tag or tag[@attr] separated
+ * by /, optionally followed by a last step @attr
+ * 
+ * [IN] struct sdf_query*: query to be compiled
+ * [IN] char*: path (must be 0-termined)
+ * [OUT] int: 0 if correct, -1 if the path is not valid
+ */
+int sdf_query_compile(struct sdf_query* q, char* path) {
+	struct sdf_query_step* 	step;
+	char* 					token;		// current step of the path
+	char* 					next;		// step after the current one
+	char* 					open;		// predicate of the step [@attr]
+	char* 					close;
+
+	q->n_steps = 0;
+	q->select = NULL;
+	q->buffer = alloc(strlen(path) + 1, 1);
+	memcpy(q->buffer, path, strlen(path));
+
+	// split the copy of the path in place
+	for(token = q->buffer; token != NULL; token = next) {
+		next = strchr(token, '/');
+		if(next != NULL)
+			*next++ = '\0';
+
+		// the selected attribute is the last step
+		if(token[0] == '@') {
+			if(next != NULL || token[1] == '\0')
+				break;
+			q->select = token + 1;
+			continue;
+		}
+
+		if(token[0] == '\0' || token[0] == '[' || q->n_steps == SDF_QUERY_STEPS)
+			break;
+		step = q->steps + q->n_steps++;
+		step->tag = token;
+		step->attribute = NULL;
+
+		// tag[@attr], the predicate ends the step
+		open = strchr(token, '[');
+		if(open != NULL) {
+			close = strchr(open, ']');
+			if(open[1] != '@' || close == NULL || close == open + 2 || close[1] != '\0')
+				break;
+			*open = '\0';
+			*close = '\0';
+			step->attribute = open + 2;
+		}
+	}
+
+	// the whole path must be consumed and select at least a tag
+	if(token != NULL || q->n_steps == 0) {
+		sdf_query_free(q);
+		return -1;
+	}
+
+	return 0;
+}
+
+/**
+ * Run a query: the first step is searched into e and its
+ * siblings, the next ones into the children of the previous
+ * match. The first match in document order is returned
+ * 
+ * [IN] struct sdf_query*: compiled query
+ * [IN] struct sdf_document*: document that contains e
+ * [IN] sdf_index: SDF element in which operate search
+ * [OUT] sdf_index: index of the element matched or SDF_NONE
+ */
+sdf_index sdf_query_run(struct sdf_query* q, struct sdf_document* d, sdf_index e) {
+	sdf_atom 	tags[SDF_QUERY_STEPS];		// atoms of the steps in this document
+	sdf_atom 	attrs[SDF_QUERY_STEPS];		// SDF_NO_ATOM when not required
+	sdf_atom 	select = SDF_NO_ATOM;		// selected attribute
+	sdf_index 	match[SDF_QUERY_STEPS];		// element matched by each step
+	int 		k;
+
+	if(q->n_steps == 0)
+		return SDF_NONE;
+
+	// names are resolved once, a name never seen can't be matched
+	for(k = 0; k < q->n_steps; k++) {
+		tags[k] = sdf_atom_find(d, q->steps[k].tag);
+		attrs[k] = q->steps[k].attribute ? sdf_atom_find(d, q->steps[k].attribute) : SDF_NO_ATOM;
+		if(tags[k] == SDF_NO_ATOM || (q->steps[k].attribute && attrs[k] == SDF_NO_ATOM))
+			return SDF_NONE;
+	}
+	if(q->select != NULL && (select = sdf_atom_find(d, q->select)) == SDF_NO_ATOM)
+		return SDF_NONE;
+
+	k = 0;
+	while(1) {
+		// first sibling that matches the step (the last one must
+		// also have the selected attribute)
+		for(; e != SDF_NONE; e = d->elements[e].sibling)
+			if(d->elements[e].atom == tags[k] && sdf_attribute_has(d, e, attrs[k]) &&
+					(k < q->n_steps - 1 || sdf_attribute_has(d, e, select)))
+				break;
+
+		if(e != SDF_NONE) {
+			// go down to the next step
+			if(k == q->n_steps - 1)
+				return e;
+			match[k++] = e;
+			e = d->elements[e].children;
+		} else {
+			// go back to the previous step, trying its next sibling
+			if(k == 0)
+				return SDF_NONE;
+			e = d->elements[match[--k]].sibling;
+		}
+	}
+}
+
+/**
+ * Run a query and return what it selects: the value of the
+ * attribute of the last step @attr, or the content of the
+ * element matched
+ * 
+ * [IN] struct sdf_query*: compiled query
+ * [IN] struct sdf_document*: document that contains e
+ * [IN] sdf_index: SDF element in which operate search
+ * [OUT] struct sdf_string*: the string selected or NULL
+ */
+struct sdf_string* sdf_query_string(struct sdf_query* q, struct sdf_document* d, sdf_index e) {
+	sdf_index a;
+
+	e = sdf_query_run(q, d, e);
+	if(e == SDF_NONE)
+		return NULL;
+	if(q->select == NULL)
+		return &d->elements[e].content;
+
+	a = sdf_attribute_search(d, d->elements[e].attributes, q->select);
+	return a != SDF_NONE ? &d->attributes[a].value : NULL;
+}
+
+/**
+ * Free the memory allocated for a compiled query
+ * 
+ * [IN] struct sdf_query*: query to be freed
+ * [OUT] void
+ */
+void sdf_query_free(struct sdf_query* q) {
+	free(q->buffer);
+	q->buffer = NULL;
+	q->n_steps = 0;
+	q->select = NULL;
 }
 
 // -------------------------------------
@@ -873,15 +3207,15 @@ void sdf_element_append(struct sdf_element** father, struct sdf_element* e) {
 // -------------------------------------
 
 /**
- * Replace the string contained into the struct with the new one
+ * Replace the string contained into the struct with the new one.
+ * The new string is materialized in the document arena, the file
+ * buffer is never modified
  * 
+ * [IN] struct sdf_document*: document that owns the string
  * [IN] struct sdf_string*: pointer to SDF string in which modify buffer
  * [IN] char*: pointer to the new string (must be 0-termined)
  * [OUT] void
  */
-void sdf_replace_string(struct sdf_string* s, char* new_str) {
-	free(s->buffer);
-	s->length = strlen(new_str);
-	s->buffer = alloc(s->length+1, sizeof(char));
-	strncpy(s->buffer, new_str, s->length);
+void sdf_replace_string(struct sdf_document* d, struct sdf_string* s, char* new_str) {
+	sdf_string_set(d, s, new_str, strlen(new_str));
 }
\ No newline at end of file
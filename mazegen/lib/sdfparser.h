@@ -39,13 +39,35 @@
 //
 // -------------------------------------
 
+/**
+ * SDF_INDEX
+ * Position of an element (or attribute) inside the arrays
+ * of its document. SDF_NONE is used as null link.
+ */
+typedef uint32_t sdf_index;
+
+#define SDF_NONE 	((sdf_index)0xFFFFFFFF)
+
+/**
+ * SDF_ATOM
+ * Tag and attribute names are interned into the atom table
+ * of their document: equal names have the same atom, so
+ * names are compared as integers. SDF_NO_ATOM is used
+ * for names never seen by the document.
+ */
+typedef uint32_t sdf_atom;
+
+#define SDF_NO_ATOM 	((sdf_atom)0xFFFFFFFF)
+#define SDF_QUERY_STEPS 16				// max steps of a query path
+
 /**
  * STRUCT SDF_STRING
- * Basic brick of an SDF document,
- * it contains a string and its length  
+ * Basic brick of an SDF document, it contains a string
+ * and its length. Parsed strings are views into the file
+ * buffer and are not 0-termined
  */
 struct sdf_string {
-	char* 	buffer;						// string
+	char* 	buffer;						// string (NULL if not present)
 	size_t 	length;						// length of the string
 };
 
@@ -53,14 +75,15 @@ struct sdf_string {
  * STRUCT SDF_ATTRIBUTE
  * The SDF attribute struct is nothing but
  * a list, that contains the couple name/value
- * and a pointer to the next attribute
+ * and the index of the next attribute
  * 
  * Ex. 	<tag attr1='value1' attr2='value2'>
  */
 struct sdf_attribute {
-	struct sdf_string* 		name;		// attribute name (attr2)
-	struct sdf_string* 		value;		// attribute value ('value2')
-	struct sdf_attribute* 	next;		// next attribute in chain (->attr1)
+	struct sdf_string 		name;		// attribute name (attr2)
+	struct sdf_string 		value;		// attribute value ('value2')
+	sdf_atom 				atom;		// interned name
+	sdf_index 			 	next;		// next attribute in chain (->attr1)
 };
 
 /**
@@ -75,32 +98,210 @@ struct sdf_attribute {
  *		<brother></brother>
  */
 struct sdf_element {
-	struct sdf_string* 		name;		// tag name (tag)
-	struct sdf_string* 		content;	// tag content (NULL)
-	struct sdf_attribute* 	attributes;	// attributes list (-> attr1)
-	struct sdf_element* 	children;	// children node list (-> son)
-	struct sdf_element* 	father;		// pointer to father (-> NULL)
-	struct sdf_element* 	sibling;	// pointer to sibling (-> brother)
+	struct sdf_string 		name;		// tag name (tag)
+	struct sdf_string 		content;	// tag content (NULL)
+	sdf_atom 				atom;		// interned tag name
+	sdf_index 			 	attributes;	// attributes list (-> attr1)
+	sdf_index 			 	children;	// first child (-> son)
+	sdf_index 			 	last_child;	// last child, for O(1) append (-> son)
+	sdf_index 			 	father;		// father (-> SDF_NONE)
+	sdf_index 			 	sibling;	// next sibling (-> brother)
+};
+
+/**
+ * STRUCT SDF_ARENA
+ * A bump allocator made of a chain of blocks. Memory can
+ * not be released one piece at a time, the whole arena
+ * is freed at once
+ */
+struct sdf_arena {
+	struct sdf_arena_block*	block;		// current block (-> previous blocks)
+	size_t 					used;		// bytes used in the current block
+};
+
+/**
+ * STRUCT SDF_ATOMS
+ * Atom table of a document: the name of each atom and an
+ * open addressing hash table from names to atoms. Names
+ * are views of the first string interned with that name
+ */
+struct sdf_atoms {
+	struct sdf_string* 		names;		// name of each atom
+	sdf_atom 				n_names;	// atoms in use
+	sdf_atom 				names_size;	// atoms allocated
+	sdf_atom* 				table;		// hash table (SDF_NO_ATOM if empty)
+	uint32_t 				mask;		// hash table size - 1
+};
+
+/**
+ * STRUCT SDF_QUERY_STEP
+ * A step of a query path: a tag name and, optionally,
+ * an attribute that the element must have
+ * 
+ * Ex. 	model[@name]
+ */
+struct sdf_query_step {
+	char* 					tag;		// tag name (tag)
+	char* 					attribute;	// required attribute (NULL)
+};
+
+/**
+ * STRUCT SDF_QUERY
+ * A compiled path query, e.g. "model[@name]/link/pose". Each step
+ * matches a child of the element matched by the previous one; a
+ * last step @attr selects an attribute of the element matched.
+ * A query can be run on any document, more times and at once
+ * 
+ * Ex. 	model[@name]/link/@name
+ */
+struct sdf_query {
+	struct sdf_query_step 	steps[SDF_QUERY_STEPS];	// steps of the path
+	int 					n_steps;	// steps in use
+	char* 					select;		// selected attribute (NULL for the content)
+	char* 					buffer;		// copy of the path, names point here
+};
+
+/**
+ * ENUM SDF_CLASS
+ * Classes of structural characters of an SDF file
+ */
+enum sdf_class {
+	SDF_LT,								// open angle bracket <
+	SDF_GT,								// close angle bracket >
+	SDF_SLASH,							// slash /
+	SDF_EQ,								// equal sign =
+	SDF_QUOTE,							// single or double quote ' "
+	SDF_SPACE,							// space, tab, carriage return, new line
+	SDF_CLASSES							// number of classes
+};
+
+/**
+ * ENUM SDF_SCANNER
+ * Implementations of the structural scanner
+ */
+enum sdf_scanner {
+	SDF_SCAN_AUTO,						// best one supported by the cpu
+	SDF_SCAN_SCALAR,					// portable, one byte at a time
+	SDF_SCAN_SSE2,						// 16 bytes at a time
+	SDF_SCAN_AVX2						// 32 bytes at a time
+};
+
+/**
+ * STRUCT SDF_STRUCTURE
+ * Structural index of a buffer: for each class of characters,
+ * a bitmap with one bit for each byte of the buffer. The bitmaps
+ * are interleaved, word w of class c is bits[w * SDF_CLASSES + c]
+ */
+struct sdf_structure {
+	uint64_t* 	bits;					// interleaved bitmaps
+	size_t 		words;					// 64-bit words of each bitmap
+	size_t 		length;					// indexed buffer length
 };
 
 /**
  * STRUCT SDF_FILE
  * Represent an SDF file and contains filename,
- * the entire content (buffer) and its length
+ * the entire content (buffer) and its length.
+ * The file must stay open while documents created
+ * from it are in use, since they refer to its content
  */ 
 struct sdf_file {
 	char* 	filename;					// sdf file name
-	char* 	buffer;						// file content
+	char* 	buffer;						// file content (read-only)
 	size_t 	length;						// file content length
+	int 	mapped;						// 1 if buffer is memory-mapped
 };
 
 /**
  * STRUCT SDF_DOCUMENT
  * An SDF document, namely a struct representation
- * of an SDF file
+ * of an SDF file. Elements and attributes are stored
+ * in two flat arrays and linked by index, strings
+ * are allocated from the document arena
  */ 
 struct sdf_document {
-	struct sdf_element* root;			// document root tag
+	struct sdf_element* 	elements;			// element array
+	sdf_index 				n_elements;			// elements in use
+	sdf_index 				elements_size;		// elements allocated
+	struct sdf_attribute* 	attributes;			// attribute array
+	sdf_index 				n_attributes;		// attributes in use
+	sdf_index 				attributes_size;	// attributes allocated
+	struct sdf_arena 		arena;				// storage for strings
+	struct sdf_atoms 		atoms;				// interned names
+	sdf_index 				root;				// document root tag
+};
+
+/**
+ * STRUCT SDF_WRITER
+ * Write an SDF document element by element, without
+ * building a DOM. The output is collected in a buffer
+ * that is flushed in big writes
+ */
+struct sdf_writer {
+	int 					fd;			// output file descriptor (-1 to keep it in memory)
+	char* 					buffer;		// output buffer
+	size_t 					length;		// bytes waiting in the buffer
+	size_t 					size;		// buffer size
+	struct sdf_string* 		tags;		// names of the open elements
+	int 					depth;		// number of open elements
+	int 					tags_size;	// names allocated
+	int 					state;		// what was written in the innermost element
+	int 					compact;	// 1 to write without indentation
+	int 					error;		// 1 if a write failed
+};
+
+/**
+ * ENUM SDF_EVENT
+ * Events returned by the pull parser, one for each call
+ */
+enum sdf_event {
+	SDF_EVENT_NONE,						// more input must be fed
+	SDF_EVENT_OPEN,						// start tag <tag attr1='value'>
+	SDF_EVENT_CONTENT,					// content of a tag without children (can be empty)
+	SDF_EVENT_CLOSE,					// end tag </tag> (also sent after <tag/>)
+	SDF_EVENT_END,						// input finished and all the tags closed
+	SDF_EVENT_ERROR						// input not valid or a tag larger than the window
+};
+
+/**
+ * STRUCT SDF_PULL_PARSER
+ * Parse an SDF file fed in chunks of any size, without
+ * building a DOM. Only the bytes of the tag that is being
+ * parsed are kept, in a window of fixed size, so files of
+ * any length are parsed with constant memory. Strings of
+ * an event are views into the window and are valid until
+ * the next chunk is fed
+ */
+struct sdf_pull_parser {
+	char* 					window;		// bytes fed and not consumed yet
+	size_t 					start;		// first byte not consumed
+	size_t 					length;		// bytes in the window
+	size_t 					size;		// window size
+	int 					last;		// 1 once the end of input was fed
+	int 					state;		// what was returned by the last event
+	struct sdf_string 		name;		// tag name (OPEN and CLOSE)
+	struct sdf_string 		content;	// tag content (CONTENT)
+	struct sdf_attribute* 	attributes;	// attributes in order, chained by next (OPEN)
+	int 					n_attributes;		// attributes of the last OPEN
+	int 					attributes_size;	// attributes allocated
+	char* 					tags;		// names of the open tags, one after the other
+	size_t 					tags_length;		// bytes of tags in use
+	size_t 					tags_size;			// bytes of tags allocated
+	size_t* 				marks;		// where the name of each open tag starts
+	int 					depth;		// number of open tags
+	int 					marks_size;	// marks allocated
+	char* 					error;		// reason of the last ERROR
+};
+
+/**
+ * STRUCT SDF_OVERRIDE
+ * Replacement for a string (content or attribute value)
+ * of a template document, used to write the template
+ * with different values without modifying it
+ */
+struct sdf_override {
+	struct sdf_string* 		target;		// string of the template to be replaced
+	char* 					value;		// new value (must be 0-termined)
 };
 
 // -------------------------------------
@@ -117,6 +318,45 @@ struct sdf_document {
  */
 int syntax_check(struct sdf_file* file);
 
+// -------------------------------------
+// 
+// STRUCTURAL SCANNER METHODS
+//
+// -------------------------------------
+
+/**
+ * Build the structural index of a buffer (first stage of the parser).
+ * The requested implementation is used if the cpu supports it,
+ * otherwise the best supported one is used
+ * 
+ * [IN] struct sdf_structure*: index to be filled
+ * [IN] char*: buffer to be indexed
+ * [IN] size_t: buffer length
+ * [IN] enum sdf_scanner: implementation to be used
+ * [OUT] enum sdf_scanner: implementation actually used
+ */
+enum sdf_scanner sdf_structure_build(struct sdf_structure* s, char* buffer, size_t length,
+	enum sdf_scanner scanner);
+
+/**
+ * Find the first position, starting from position, that contains
+ * a character of one of the classes in mask (1 << enum sdf_class)
+ * 
+ * [IN] struct sdf_structure*: structural index
+ * [IN] size_t: first position to be checked
+ * [IN] unsigned: classes mask
+ * [OUT] size_t: position found or indexed buffer length
+ */
+size_t sdf_structure_next(struct sdf_structure* s, size_t position, unsigned mask);
+
+/**
+ * Free the memory allocated for the structural index
+ * 
+ * [IN] struct sdf_structure*: index to be freed
+ * [OUT] void
+ */
+void sdf_structure_free(struct sdf_structure* s);
+
 // -------------------------------------
 // 
 // FILE METHODS
@@ -124,7 +364,8 @@ int syntax_check(struct sdf_file* file);
 // -------------------------------------
 
 /**
- * Open an sdf file and copy the content into file structure
+ * Open an sdf file and make its content available into file structure.
+ * Regular files are memory-mapped, the others are read into memory
  * 
  * [IN] struct sdf_file*: pointer to the struct to be filled
  * [IN] uint8_t const*: sdf filename * 	
@@ -146,6 +387,14 @@ void sdf_file_close(struct sdf_file* file);
 //
 // -------------------------------------
 
+/**
+ * Initialize an empty SDF document (without root)
+ * 
+ * [IN] struct sdf_document*: document to be initialized
+ * [OUT] void
+ */
+void sdf_document_init(struct sdf_document* document);
+
 /**
  * Parse an SDF file and create a SDF document with
  * element, attribute and so on. 
@@ -156,15 +405,50 @@ void sdf_file_close(struct sdf_file* file);
  */
 void sdf_document_create(struct sdf_file* file, struct sdf_document* document);
 
+/**
+ * Parse an SDF file with more threads. The children of the first
+ * element with more than one child (e.g. the models of a world)
+ * are parsed in parallel and then linked under it. The tree is
+ * the same built by sdf_document_create
+ * 
+ * [IN] struct sdf_file*: pointer to sdf file to be analyzed
+ * [IN] struct sdf_document*: result will be left here
+ * [IN] int: number of threads
+ * [OUT] void
+ */
+void sdf_document_create_parallel(struct sdf_file* file, struct sdf_document* document, int threads);
+
 /**
  * Export an SDF document into a file.
  * 
  * [IN] struct sdf_document*: document to be printed
  * [IN] char*: name of the file in which write
- * [OUT] void
+ * [OUT] int: 0 if correct
  */
 int sdf_document_print(struct sdf_document* d, char* filename);
 
+/**
+ * Export an SDF document into a file with more threads. The
+ * children of the first element with more than one child are
+ * formatted in parallel, the file is the same written by
+ * sdf_document_print
+ * 
+ * [IN] struct sdf_document*: document to be printed
+ * [IN] char*: name of the file in which write
+ * [IN] int: number of threads
+ * [OUT] int: 0 if correct
+ */
+int sdf_document_print_parallel(struct sdf_document* d, char* filename, int threads);
+
+/**
+ * Export an SDF document into a file, without indentation.
+ * 
+ * [IN] struct sdf_document*: document to be printed
+ * [IN] char*: name of the file in which write
+ * [OUT] int: 0 if correct
+ */
+int sdf_document_print_compact(struct sdf_document* d, char* filename);
+
 /**
  * Close an SDF document and frees the allocated memory
  * 
@@ -173,6 +457,54 @@ int sdf_document_print(struct sdf_document* d, char* filename);
  */
 void sdf_document_close(struct sdf_document* document);
 
+// -------------------------------------
+// 
+// SDF PULL PARSER METHODS
+//
+// -------------------------------------
+
+/**
+ * Initialize a pull parser. The window must be larger than
+ * the largest tag (or content) of the input
+ * 
+ * [IN] struct sdf_pull_parser*: parser to be initialized
+ * [IN] size_t: window size in bytes (0 for the default one)
+ * [OUT] void
+ */
+void sdf_parser_init(struct sdf_pull_parser* p, size_t window);
+
+/**
+ * Feed the next chunk of input. The bytes already consumed are
+ * dropped and as many bytes as fit into the window are copied,
+ * the rest must be fed again after the events have been read.
+ * Feed a chunk of length 0 at the end of input
+ * 
+ * [IN] struct sdf_pull_parser*: parser
+ * [IN] const char*: chunk of input
+ * [IN] size_t: chunk length (0 at the end of input)
+ * [OUT] size_t: bytes of the chunk copied into the window
+ */
+size_t sdf_parser_feed(struct sdf_pull_parser* p, const char* buffer, size_t length);
+
+/**
+ * Parse the next event. Name, content and attributes of the event
+ * are left into the parser. SDF_EVENT_NONE is returned when the
+ * window does not hold the whole next tag, then more input must
+ * be fed. END and ERROR are returned again by the next calls
+ * 
+ * [IN] struct sdf_pull_parser*: parser
+ * [OUT] enum sdf_event: the event
+ */
+enum sdf_event sdf_parser_next_event(struct sdf_pull_parser* p);
+
+/**
+ * Free the memory allocated for a pull parser
+ * 
+ * [IN] struct sdf_pull_parser*: parser to be freed
+ * [OUT] void
+ */
+void sdf_parser_close(struct sdf_pull_parser* p);
+
 // -------------------------------------
 // 
 // SDF ELEMENT METHODS (TO BE ADJ.)
@@ -180,40 +512,233 @@ void sdf_document_close(struct sdf_document* document);
 // -------------------------------------
 
 /**
- * Search a tag into an element e. Privilege children node
+ * Get the element stored at index e. The pointer is valid
+ * until a new element is added to the document
  * 
- * [IN] struct sdf_element*: pointer to SDF element in which operate search
+ * [IN] struct sdf_document*: document that contains the element
+ * [IN] sdf_index: index of the element
+ * [OUT] struct sdf_element*: pointer to the element struct
+ */
+struct sdf_element* sdf_element_get(struct sdf_document* d, sdf_index e);
+
+/**
+ * Get the attribute stored at index a. The pointer is valid
+ * until a new attribute is added to the document
+ * 
+ * [IN] struct sdf_document*: document that contains the attribute
+ * [IN] sdf_index: index of the attribute
+ * [OUT] struct sdf_attribute*: pointer to the attribute struct
+ */
+struct sdf_attribute* sdf_attribute_get(struct sdf_document* d, sdf_index a);
+
+/**
+ * Search a tag into the element e, its siblings and all their
+ * descendants, in document order (depth first)
+ * 
+ * [IN] struct sdf_document*: document that contains the element
+ * [IN] sdf_index: SDF element in which operate search
  * [IN] char*: name of tag that must be searched
- * [OUT] struct sdf_element*: pointer to the element struct or NULL
+ * [OUT] sdf_index: index of the element or SDF_NONE
  */
-struct sdf_element* sdf_element_deep_search(struct sdf_element* e, char* tag_name);
+sdf_index sdf_element_deep_search(struct sdf_document* d, sdf_index e, char* tag_name);
 
 /**
  * Search a tag into an element e. Avoid children nodes
  * 
- * [IN] struct sdf_element*: pointer to SDF element in which operate search
+ * [IN] struct sdf_document*: document that contains the element
+ * [IN] sdf_index: SDF element in which operate search
  * [IN] char*: name of tag that must be searched
- * [OUT] struct sdf_element*: pointer to the element struct or NULL
+ * [OUT] sdf_index: index of the element or SDF_NONE
  */
-struct sdf_element* sdf_element_search(struct sdf_element* e, char* tag_name);
+sdf_index sdf_element_search(struct sdf_document* d, sdf_index e, char* tag_name);
 
 /**
  * Search an attribute into an attribute list a
  * 
- * [IN] struct sdf_attribute*: pointer to SDF attribute list in which operate search
+ * [IN] struct sdf_document*: document that contains the list
+ * [IN] sdf_index: SDF attribute list in which operate search
  * [IN] char*: name of the attribute that must be searched
- * [OUT] struct sdf_attribute*: pointer to the attribute struct or NULL
+ * [OUT] sdf_index: index of the attribute or SDF_NONE
  */
-struct sdf_attribute* sdf_attribute_search(struct sdf_attribute* a, char* attr_name);
+sdf_index sdf_attribute_search(struct sdf_document* d, sdf_index a, char* attr_name);
 
 /**
  * Append the element e to father as children
  * 
- * [IN] struct sdf_element**: pointer to SDF element in which append e
- * [IN] struct sdf_element*: element that must be appended
+ * [IN] struct sdf_document*: document that contains both elements
+ * [IN] sdf_index: SDF element in which append e
+ * [IN] sdf_index: element that must be appended
+ * [OUT] void
+ */
+void sdf_element_append(struct sdf_document* d, sdf_index father, sdf_index e);
+
+/**
+ * Create a deep copy of the element e, its attributes and its children,
+ * into the document dst (that can be the same of src).
+ * Siblings of e are not copied and the copy has no father.
+ * 
+ * [IN] struct sdf_document*: document in which create the copy
+ * [IN] struct sdf_document*: document that contains e
+ * [IN] sdf_index: element that must be copied
+ * [OUT] sdf_index: the new element
+ */
+sdf_index sdf_element_clone(struct sdf_document* dst, struct sdf_document* src, sdf_index e);
+
+// -------------------------------------
+// 
+// SDF ATOM AND QUERY METHODS
+//
+// -------------------------------------
+
+/**
+ * Intern a name into the atom table of a document. The name
+ * must stay valid while the document is in use
+ * 
+ * [IN] struct sdf_document*: document that owns the table
+ * [IN] struct sdf_string*: name to be interned
+ * [OUT] sdf_atom: atom of the name
+ */
+sdf_atom sdf_atom_intern(struct sdf_document* d, struct sdf_string* name);
+
+/**
+ * Find the atom of a name, without adding it
+ * 
+ * [IN] struct sdf_document*: document that owns the table
+ * [IN] char*: name (must be 0-termined)
+ * [OUT] sdf_atom: atom of the name or SDF_NO_ATOM
+ */
+sdf_atom sdf_atom_find(struct sdf_document* d, char* name);
+
+/**
+ * Compile a query path made of steps tag or tag[@attr] separated
+ * by /, optionally followed by a last step @attr
+ * 
+ * [IN] struct sdf_query*: query to be compiled
+ * [IN] char*: path (must be 0-termined)
+ * [OUT] int: 0 if correct, -1 if the path is not valid
+ */
+int sdf_query_compile(struct sdf_query* q, char* path);
+
+/**
+ * Run a query: the first step is searched into e and its
+ * siblings, the next ones into the children of the previous
+ * match. The first match in document order is returned
+ * 
+ * [IN] struct sdf_query*: compiled query
+ * [IN] struct sdf_document*: document that contains e
+ * [IN] sdf_index: SDF element in which operate search
+ * [OUT] sdf_index: index of the element matched or SDF_NONE
+ */
+sdf_index sdf_query_run(struct sdf_query* q, struct sdf_document* d, sdf_index e);
+
+/**
+ * Run a query and return what it selects: the value of the
+ * attribute of the last step @attr, or the content of the
+ * element matched
+ * 
+ * [IN] struct sdf_query*: compiled query
+ * [IN] struct sdf_document*: document that contains e
+ * [IN] sdf_index: SDF element in which operate search
+ * [OUT] struct sdf_string*: the string selected or NULL
+ */
+struct sdf_string* sdf_query_string(struct sdf_query* q, struct sdf_document* d, sdf_index e);
+
+/**
+ * Free the memory allocated for a compiled query
+ * 
+ * [IN] struct sdf_query*: query to be freed
+ * [OUT] void
+ */
+void sdf_query_free(struct sdf_query* q);
+
+// -------------------------------------
+// 
+// SDF WRITER METHODS
+//
+// -------------------------------------
+
+/**
+ * Open a file and prepare the writer. Pass NULL to write
+ * in the terminal. Set compact to 1 after opening to write
+ * without indentation
+ * 
+ * [IN] struct sdf_writer*: writer to be initialized
+ * [IN] char*: name of the file in which write
+ * [OUT] int: 0 if correct
+ */
+int sdf_writer_open(struct sdf_writer* w, char* filename);
+
+/**
+ * Close all the elements still open, flush the buffer
+ * and close the file
+ * 
+ * [IN] struct sdf_writer*: writer to be closed
+ * [OUT] int: 0 if everything was written
+ */
+int sdf_writer_close(struct sdf_writer* w);
+
+/**
+ * Open a new element, child of the innermost open one.
+ * The name must stay valid until the element is closed
+ * 
+ * [IN] struct sdf_writer*: writer
+ * [IN] char*: tag name (must be 0-termined)
+ * [OUT] void
+ */
+void sdf_writer_element_open(struct sdf_writer* w, char* name);
+
+/**
+ * Add an attribute to the element just opened
+ * 
+ * [IN] struct sdf_writer*: writer
+ * [IN] char*: attribute name (must be 0-termined)
+ * [IN] char*: attribute value, quotes included (must be 0-termined)
+ * [OUT] void
+ */
+void sdf_writer_attribute(struct sdf_writer* w, char* name, char* value);
+
+/**
+ * Write the content of the element just opened
+ * 
+ * [IN] struct sdf_writer*: writer
+ * [IN] char*: tag content (must be 0-termined)
+ * [OUT] void
+ */
+void sdf_writer_text(struct sdf_writer* w, char* text);
+
+/**
+ * Close the innermost open element
+ * 
+ * [IN] struct sdf_writer*: writer
+ * [OUT] void
+ */
+void sdf_writer_element_close(struct sdf_writer* w);
+
+/**
+ * Open a new element copying name and attributes of the element e
+ * of a document. Children of e are not written
+ * 
+ * [IN] struct sdf_writer*: writer
+ * [IN] struct sdf_document*: document that contains e
+ * [IN] sdf_index: element to be copied
+ * [OUT] void
+ */
+void sdf_writer_template_open(struct sdf_writer* w, struct sdf_document* d, sdf_index e);
+
+/**
+ * Write the element e of a document with its attributes and its
+ * children. Strings listed in the overrides are replaced by the
+ * new values, the document is not modified
+ * 
+ * [IN] struct sdf_writer*: writer
+ * [IN] struct sdf_document*: document that contains e
+ * [IN] sdf_index: element to be written
+ * [IN] struct sdf_override*: strings to be replaced (can be NULL)
+ * [IN] int: number of overrides
  * [OUT] void
  */
-void sdf_element_append(struct sdf_element** father, struct sdf_element* e);
+void sdf_writer_template(struct sdf_writer* w, struct sdf_document* d, sdf_index e,
+	struct sdf_override* overrides, int n);
 
 // -------------------------------------
 // 
@@ -222,10 +747,12 @@ void sdf_element_append(struct sdf_element** father, struct sdf_element* e);
 // -------------------------------------
 
 /**
- * Replace the string contained into the struct with the new one
+ * Replace the string contained into the struct with the new one.
+ * The new string is materialized in the document arena
  * 
+ * [IN] struct sdf_document*: document that owns the string
  * [IN] struct sdf_string*: pointer to SDF string in which modify buffer
  * [IN] char*: pointer to the new string (must be 0-termined)
  * [OUT] void
  */
-void sdf_replace_string(struct sdf_string* s, char* new_str);
\ No newline at end of file
+void sdf_replace_string(struct sdf_document* d, struct sdf_string* s, char* new_str);
\ No newline at end of file
@@ -0,0 +1,423 @@
+/**
+ * SOLVER
+ * Shortest paths between two blocks of a maze (BFS, A*
+ * and dead-end filling) with reusable scratch buffers
+ */
+
+#include "solver.h"
+#include <stdlib.h>
+#include <string.h>
+
+// ----------------------------
+// BLOCK STATE
+// ---------------------------.
+
+# define STATE_FROM     0b00000111  // direction code of the previous block
+# define STATE_COST     0b00011000  // cost (mod 4) of the block (A* only)
+# define STATE_CLOSED   0b00100000  // the block has been expanded (A* only)
+# define STATE_FILLED   0b01000000  // the block is a filled dead end
+# define COST_SHIFT     3
+
+# define FROM_NONE      0           // the block has not been reached
+# define FROM_START     5           // the block is the start
+                                    // 1..4: reached moving towards the
+                                    // direction (1 << (code - 1))
+
+# define MIN_QUEUE      1024        // initial capacity of the queues
+
+// -----------------------------------------------------
+// PRIVATE METHOD
+// -----------------------------------------------------
+
+/**
+ * Step along x and y for each direction (bit index of the direction)
+ */
+static const int step_x[4] = {1, 0, -1, 0};
+static const int step_y[4] = {0, 1, 0, -1};
+
+/**
+ * Grow a buffer of indexes so that it can contain at least need indexes.
+ * The capacity is doubled, so that a buffer is reallocated only a few times
+ *
+ * [IN]     uint32_t**: pointer to the buffer
+ * [IN]     size_t*: pointer to the capacity of the buffer
+ * [IN]     size_t: indexes needed
+ * [OUT]    int: -1 in case of low mem availability, 0 in case of success
+ */
+static int reserve(uint32_t** buf, size_t* cap, size_t need) {
+    uint32_t*   grown;
+    size_t      n = *cap;
+
+    if (need <= n)
+        return 0;
+
+    while (n < need)
+        n *= 2;
+    grown = realloc(*buf, n * sizeof(uint32_t));
+    if (grown == NULL)
+        return -1;
+
+    *buf = grown;
+    *cap = n;
+    return 0;
+}
+
+/**
+ * Get the index of the neighbor of block i towards dir, if it can be walked
+ *
+ * [IN]     solver*: pointer to the solver struct
+ * [IN]     uint32_t: index of the block
+ * [IN]     uint32_t: y position of the block
+ * [IN]     int: bit index of the direction
+ * [IN]     uint32_t*: index of the neighbor will be left here
+ * [OUT]    int: 1 if the neighbor is a free block, 0 otherwise
+ */
+static inline int walk(struct solver* s, uint32_t i, uint32_t y, int dir, uint32_t* n) {
+    struct maze*    m = s->m;
+    size_t          cells = (size_t)m->width * m->height;
+
+    // stay inside the maze
+    if ((dir == 0 && (size_t)i + m->width >= cells) || (dir == 1 && y + 1 >= m->width) ||
+        (dir == 2 && i < m->width) || (dir == 3 && y == 0))
+        return 0;
+
+    *n = i + step_x[dir] * (int64_t)m->width + step_y[dir];
+    return !(m->cells[*n] & CELL_WALL) && !(s->state[*n] & STATE_FILLED);
+}
+
+/**
+ * Check the start and the goal and clear the state of the blocks
+ *
+ * [IN]     solver*: pointer to the solver struct
+ * [IN]     uint32_t: start position (x, y)
+ * [IN]     uint32_t: goal position (x, y)
+ * [OUT]    int: 1 if both are free blocks of the maze, 0 otherwise
+ */
+static int prepare(struct solver* s, uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1) {
+    struct maze* m = s->m;
+
+    if (x0 >= m->height || y0 >= m->width || x1 >= m->height || y1 >= m->width)
+        return 0;
+    if ((CELL(m, x0, y0) & CELL_WALL) || (CELL(m, x1, y1) & CELL_WALL))
+        return 0;
+
+    memset(s->state, 0, (size_t)m->width * m->height);
+    return 1;
+}
+
+/**
+ * Copy into s->path the path that reaches the goal, going back
+ * from the goal to the start along the direction codes
+ *
+ * [IN]     solver*: pointer to the solver struct
+ * [IN]     uint32_t: index of the goal
+ * [OUT]    long: blocks of the path, -1 in case of low mem availability
+ */
+static long trace(struct solver* s, uint32_t goal) {
+    uint32_t    i;
+    size_t      k;
+    int         code;
+
+    // measure the path
+    s->length = 1;
+    for (i = goal; (code = s->state[i] & STATE_FROM) != FROM_START; s->length++)
+        i -= step_x[code - 1] * (int64_t)s->m->width + step_y[code - 1];
+
+    if (reserve(&s->path, &s->path_cap, s->length))
+        return -1;
+
+    // fill it from the end
+    k = s->length;
+    for (i = goal; (code = s->state[i] & STATE_FROM) != FROM_START; ) {
+        s->path[--k] = i;
+        i -= step_x[code - 1] * (int64_t)s->m->width + step_y[code - 1];
+    }
+    s->path[0] = i;
+
+    return s->length;
+}
+
+/**
+ * Breadth-first search level by level: the blocks of a level are in
+ * open and the blocks of the next one are collected into next. Filled
+ * blocks are skipped, the state must be already cleared
+ *
+ * [IN]     solver*: pointer to the solver struct
+ * [IN]     uint32_t: index of the start
+ * [IN]     uint32_t: index of the goal
+ * [OUT]    long: blocks of the path, 0 if there is no path,
+ *                -1 in case of low mem availability
+ */
+static long bfs(struct solver* s, uint32_t start, uint32_t goal) {
+    uint32_t*   level;
+    size_t      cap;
+    size_t      k, n_open, n_next;
+    uint32_t    i, n;
+    int         dir;
+
+    s->state[start] = (s->state[start] & ~STATE_FROM) | FROM_START;
+    s->open[0] = start;
+    n_open = 1;
+
+    while (n_open > 0 && (s->state[goal] & STATE_FROM) == FROM_NONE) {
+        n_next = 0;
+        for (k = 0; k < n_open; k++) {
+            i = s->open[k];
+            for (dir = 0; dir < 4; dir++) {
+                if (!walk(s, i, i % s->m->width, dir, &n) || (s->state[n] & STATE_FROM))
+                    continue;
+                if (reserve(&s->next, &s->next_cap, n_next + 1))
+                    return -1;
+                s->state[n] |= dir + 1;
+                s->next[n_next++] = n;
+            }
+        }
+
+        // the next level becomes the current one
+        level = s->open;
+        s->open = s->next;
+        s->next = level;
+        cap = s->open_cap;
+        s->open_cap = s->next_cap;
+        s->next_cap = cap;
+        n_open = n_next;
+    }
+
+    if ((s->state[goal] & STATE_FROM) == FROM_NONE)
+        return 0;
+
+    return trace(s, goal);
+}
+
+/**
+ * Manhattan distance of the block i from the goal
+ *
+ * [IN]     uint32_t: index of the block
+ * [IN]     uint32_t: maze width
+ * [IN]     uint32_t: goal position (x, y)
+ * [OUT]    uint32_t: distance
+ */
+static inline uint32_t manhattan(uint32_t i, uint32_t width, uint32_t x1, uint32_t y1) {
+    uint32_t x = i / width;
+    uint32_t y = i - x * width;
+
+    return (x > x1 ? x - x1 : x1 - x) + (y > y1 ? y - y1 : y1 - y);
+}
+
+/**
+ * Fill the dead ends of the maze, except start and goal. A dead end
+ * is a free block with at most one free neighbor: once filled, its
+ * neighbor may become a dead end too
+ *
+ * [IN]     solver*: pointer to the solver struct
+ * [IN]     uint32_t: index of the start
+ * [IN]     uint32_t: index of the goal
+ * [OUT]    void
+ */
+static void fill_dead_ends(struct solver* s, uint32_t start, uint32_t goal) {
+    struct maze*    m = s->m;
+    size_t          cells = (size_t)m->width * m->height;
+    uint32_t        i, j, n, last, exits;
+    int             dir;
+
+    for (i = 0; i < cells; i++) {
+        // follow the corridor that each dead end leaves
+        for (j = i; j != start && j != goal && !(m->cells[j] & CELL_WALL) &&
+                !(s->state[j] & STATE_FILLED); j = last) {
+            // count the free neighbors
+            for (dir = 0, exits = 0; dir < 4; dir++)
+                if (walk(s, j, j % m->width, dir, &n)) {
+                    last = n;
+                    exits++;
+                }
+
+            if (exits > 1)
+                break;
+            s->state[j] |= STATE_FILLED;
+            if (exits == 0)
+                break;
+        }
+    }
+}
+
+// -----------------------------------------------------
+// PUBLIC METHOD
+// -----------------------------------------------------
+
+/**
+ * Init the solver of a maze. The maze can change between solves,
+ * but not its size
+ *
+ * [IN]     solver*: pointer to the solver to be initialized
+ * [IN]     maze*: pointer to the maze struct
+ * [OUT]    int: -1 in case of low mem availability or too many blocks
+ *               to be indexed with 32 bits, 0 in case of success
+ */
+int init_solver(struct solver* s, struct maze* m) {
+    size_t cells = (size_t)m->width * m->height;
+
+    if (cells > UINT32_MAX)
+        return -1;
+
+    s->m = m;
+    s->state = malloc(cells);
+    s->open_cap = s->next_cap = s->path_cap = MIN_QUEUE;
+    s->open = malloc(MIN_QUEUE * sizeof(uint32_t));
+    s->next = malloc(MIN_QUEUE * sizeof(uint32_t));
+    s->path = malloc(MIN_QUEUE * sizeof(uint32_t));
+    s->length = 0;
+
+    // out of memory
+    if (s->state == NULL || s->open == NULL || s->next == NULL || s->path == NULL) {
+        free_solver(s);
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * Free the memory allocated for the solver
+ *
+ * [IN]     solver*: pointer to the solver struct
+ * [OUT]    void
+ */
+void free_solver(struct solver* s) {
+    free(s->state);
+    free(s->open);
+    free(s->next);
+    free(s->path);
+    s->state = NULL;
+    s->open = s->next = s->path = NULL;
+}
+
+/**
+ * Find a shortest path between two free blocks with a breadth-first search
+ *
+ * [IN]     solver*: pointer to the solver struct
+ * [IN]     uint32_t: start position (x, y)
+ * [IN]     uint32_t: goal position (x, y)
+ * [OUT]    long: blocks of the path (left into s->path), 0 if there is no
+ *                path, -1 in case of low mem availability
+ */
+long solve_bfs(struct solver* s, uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1) {
+    s->length = 0;
+    if (!prepare(s, x0, y0, x1, y1))
+        return 0;
+
+    return bfs(s, x0 * s->m->width + y0, x1 * s->m->width + y1);
+}
+
+/**
+ * Find a shortest path between two free blocks with A*, using the
+ * manhattan distance from the goal as heuristic. Each step costs 1
+ * and the heuristic is consistent, so the cost (steps + distance) of
+ * a new block is the cost of the expanded one or that plus 2: only two
+ * buckets are needed, the blocks to be expanded now (open) and the
+ * ones to be expanded later (next). The cost of a block is kept mod 4,
+ * that is enough to tell the two buckets apart
+ *
+ * [IN]     solver*: pointer to the solver struct
+ * [IN]     uint32_t: start position (x, y)
+ * [IN]     uint32_t: goal position (x, y)
+ * [OUT]    long: blocks of the path (left into s->path), 0 if there is no
+ *                path, -1 in case of low mem availability
+ */
+long solve_astar(struct solver* s, uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1) {
+    uint32_t    width = s->m->width;
+    uint32_t    goal = x1 * width + y1;
+    uint32_t*   bucket;
+    size_t      cap;
+    size_t      n_open, n_next;
+    uint32_t    cost, steps, c;
+    uint32_t    i, n;
+    uint8_t     st;
+    int         dir;
+
+    s->length = 0;
+    if (!prepare(s, x0, y0, x1, y1))
+        return 0;
+
+    // the start has the smallest cost
+    i = x0 * width + y0;
+    cost = manhattan(i, width, x1, y1);
+    s->state[i] = FROM_START | (cost & 3) << COST_SHIFT;
+    s->open[0] = i;
+    n_open = 1;
+    n_next = 0;
+
+    while (1) {
+        // go to the next bucket
+        if (n_open == 0) {
+            if (n_next == 0)
+                return 0;
+            bucket = s->open;
+            s->open = s->next;
+            s->next = bucket;
+            cap = s->open_cap;
+            s->open_cap = s->next_cap;
+            s->next_cap = cap;
+            n_open = n_next;
+            n_next = 0;
+            cost += 2;
+        }
+
+        i = s->open[--n_open];
+        st = s->state[i];
+
+        // already expanded or moved to the current bucket
+        if ((st & STATE_CLOSED) || (st & STATE_COST) >> COST_SHIFT != (cost & 3))
+            continue;
+        s->state[i] |= STATE_CLOSED;
+        if (i == goal)
+            return trace(s, goal);
+
+        steps = cost - manhattan(i, width, x1, y1) + 1;
+        for (dir = 0; dir < 4; dir++) {
+            if (!walk(s, i, i % width, dir, &n))
+                continue;
+            st = s->state[n];
+            c = steps + manhattan(n, width, x1, y1);
+
+            // a block is updated only if it is new or it gets a smaller cost
+            if ((st & STATE_CLOSED) || ((st & STATE_FROM) != FROM_NONE &&
+                    (c != cost || (st & STATE_COST) >> COST_SHIFT == (cost & 3))))
+                continue;
+            s->state[n] = (dir + 1) | (c & 3) << COST_SHIFT;
+
+            if (c == cost) {
+                if (reserve(&s->open, &s->open_cap, n_open + 1))
+                    return -1;
+                s->open[n_open++] = n;
+            } else {
+                if (reserve(&s->next, &s->next_cap, n_next + 1))
+                    return -1;
+                s->next[n_next++] = n;
+            }
+        }
+    }
+}
+
+/**
+ * Find a shortest path between two free blocks by dead-end filling: the
+ * dead ends are filled until only the blocks between start and goal are
+ * left, then the path is searched among them. In a perfect maze only
+ * the path is left
+ *
+ * [IN]     solver*: pointer to the solver struct
+ * [IN]     uint32_t: start position (x, y)
+ * [IN]     uint32_t: goal position (x, y)
+ * [OUT]    long: blocks of the path (left into s->path), 0 if there is no
+ *                path, -1 in case of low mem availability
+ */
+long solve_dead_end(struct solver* s, uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1) {
+    uint32_t start = x0 * s->m->width + y0;
+    uint32_t goal = x1 * s->m->width + y1;
+
+    s->length = 0;
+    if (!prepare(s, x0, y0, x1, y1))
+        return 0;
+
+    fill_dead_ends(s, start, goal);
+    return bfs(s, start, goal);
+}
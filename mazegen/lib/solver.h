@@ -0,0 +1,114 @@
+/**
+ * SOLVER
+ * Shortest paths between two blocks of a maze (BFS, A*
+ * and dead-end filling) with reusable scratch buffers
+ *
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2018, Gabriele Ara, Gabriele Serra
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef SOLVER_H
+#define SOLVER_H
+
+#include "maze.h"
+
+/**
+ * STRUCT SOLVER
+ * Scratch buffers of the searches on a maze. They are allocated once
+ * and only grow, so that repeated solves on the same maze allocate
+ * nothing. A path is the list of the indexes (x * width + y) of its
+ * blocks, from the start to the goal
+ */
+struct solver {
+    struct maze*    m;          // maze to be solved
+    uint8_t*        state;      // search state of each block
+    uint32_t*       open;       // blocks to be expanded now
+    size_t          open_cap;   // capacity of open
+    uint32_t*       next;       // blocks to be expanded later
+    size_t          next_cap;   // capacity of next
+    uint32_t*       path;       // path found by the last solve
+    size_t          path_cap;   // capacity of path
+    size_t          length;     // number of blocks of the path
+};
+
+/**
+ * Init the solver of a maze. The maze can change between solves,
+ * but not its size
+ * 
+ * [IN]     solver*: pointer to the solver to be initialized
+ * [IN]     maze*: pointer to the maze struct
+ * [OUT]    int: -1 in case of low mem availability or too many blocks
+ *               to be indexed with 32 bits, 0 in case of success
+ */
+int init_solver(struct solver* s, struct maze* m);
+
+/**
+ * Free the memory allocated for the solver
+ * 
+ * [IN]     solver*: pointer to the solver struct
+ * [OUT]    void
+ */
+void free_solver(struct solver* s);
+
+/**
+ * Find a shortest path between two free blocks with a breadth-first search
+ * 
+ * [IN]     solver*: pointer to the solver struct
+ * [IN]     uint32_t: start position (x, y)
+ * [IN]     uint32_t: goal position (x, y)
+ * [OUT]    long: blocks of the path (left into s->path), 0 if there is no
+ *                path, -1 in case of low mem availability
+ */
+long solve_bfs(struct solver* s, uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1);
+
+/**
+ * Find a shortest path between two free blocks with A*, using the
+ * manhattan distance from the goal as heuristic
+ * 
+ * [IN]     solver*: pointer to the solver struct
+ * [IN]     uint32_t: start position (x, y)
+ * [IN]     uint32_t: goal position (x, y)
+ * [OUT]    long: blocks of the path (left into s->path), 0 if there is no
+ *                path, -1 in case of low mem availability
+ */
+long solve_astar(struct solver* s, uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1);
+
+/**
+ * Find a shortest path between two free blocks by dead-end filling: the
+ * dead ends are filled until only the blocks between start and goal are
+ * left, then the path is searched among them. In a perfect maze only
+ * the path is left
+ * 
+ * [IN]     solver*: pointer to the solver struct
+ * [IN]     uint32_t: start position (x, y)
+ * [IN]     uint32_t: goal position (x, y)
+ * [OUT]    long: blocks of the path (left into s->path), 0 if there is no
+ *                path, -1 in case of low mem availability
+ */
+long solve_dead_end(struct solver* s, uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1);
+
+
+#endif
@@ -0,0 +1,326 @@
+/**
+ * TREE
+ * Ancestors of the spanning tree of a perfect maze, so that
+ * distances and paths are found without any search
+ */
+
+#include "tree.h"
+#include <stdlib.h>
+
+// -----------------------------------------------------
+// PRIVATE METHOD
+// -----------------------------------------------------
+
+/**
+ * Step along x and y for each direction (bit index of the direction)
+ */
+static const int step_x[4] = {1, 0, -1, 0};
+static const int step_y[4] = {0, 1, 0, -1};
+
+/**
+ * Get the node of the tree at position (x, y) of the maze
+ *
+ * [IN]     maze_tree*: pointer to the tree struct
+ * [IN]     uint32_t: node position (x, y), both odd
+ * [OUT]    uint32_t: the node
+ */
+static inline uint32_t node_at(struct maze_tree* t, uint32_t x, uint32_t y) {
+    return (x - 1) / 2 * t->cols + (y - 1) / 2;
+}
+
+/**
+ * Get the index (x * width + y) of the block of a node
+ *
+ * [IN]     maze_tree*: pointer to the tree struct
+ * [IN]     uint32_t: the node
+ * [OUT]    uint32_t: index of its block
+ */
+static inline uint32_t block_of(struct maze_tree* t, uint32_t v) {
+    return (2 * (v / t->cols) + 1) * t->m->width + 2 * (v % t->cols) + 1;
+}
+
+/**
+ * Find the nodes at the ends of a free block: a node block is both
+ * ends, a passage lies between two nodes
+ *
+ * [IN]     maze_tree*: pointer to the tree struct
+ * [IN]     uint32_t: block position (x, y)
+ * [IN]     uint32_t*: the two nodes will be left here
+ * [OUT]    int: -1 if the block is not in the tree, 0 otherwise
+ */
+static int locate(struct maze_tree* t, uint32_t x, uint32_t y, uint32_t* ends) {
+    struct maze* m = t->m;
+
+    // nodes and passages are inside the outer walls
+    if (x < 1 || y < 1 || x + 1 >= m->height || y + 1 >= m->width)
+        return -1;
+    if ((CELL(m, x, y) & CELL_WALL) || (x % 2 == 0 && y % 2 == 0))
+        return -1;
+
+    ends[0] = node_at(t, x - (x % 2 == 0), y - (y % 2 == 0));
+    ends[1] = node_at(t, x + (x % 2 == 0), y + (y % 2 == 0));
+    return 0;
+}
+
+/**
+ * Choose the ends of two blocks that are closest in the tree
+ *
+ * [IN]     maze_tree*: pointer to the tree struct
+ * [IN]     uint32_t: first block position (x, y)
+ * [IN]     uint32_t: second block position (x, y)
+ * [IN]     uint32_t*: the closest ends and their ancestor will be left here
+ * [OUT]    long: length of the path between the blocks, -1 if a block
+ *                is not in the tree
+ */
+static long closest_ends(struct maze_tree* t, uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1,
+        uint32_t* best) {
+    uint32_t    a[2], b[2];
+    uint32_t    l;
+    long        d, dist = -1;
+    int         i, j;
+
+    if (locate(t, x0, y0, a) || locate(t, x1, y1, b))
+        return -1;
+    if (x0 == x1 && y0 == y1) {
+        best[0] = best[1] = best[2] = a[0];
+        return 0;
+    }
+
+    // a path from a passage starts with a step to one of its ends
+    for (i = 0; i < 2; i++)
+        for (j = 0; j < 2; j++) {
+            l = tree_lca(t, a[i], b[j]);
+            d = 2 * ((long)t->depth[a[i]] + t->depth[b[j]] - 2 * (long)t->depth[l]) +
+                    (a[0] != a[1]) + (b[0] != b[1]);
+            if (dist < 0 || d < dist) {
+                dist = d;
+                best[0] = a[i];
+                best[1] = b[j];
+                best[2] = l;
+            }
+        }
+
+    return dist;
+}
+
+// -----------------------------------------------------
+// PUBLIC METHOD
+// -----------------------------------------------------
+
+/**
+ * Build the tree of a maze created by create_maze or create_maze_tiled.
+ * The maze can't change until the tree is freed
+ *
+ * [IN]     maze_tree*: pointer to the tree to be initialized
+ * [IN]     maze*: pointer to the maze struct
+ * [OUT]    int: -1 in case of low mem availability or if the maze is not
+ *               a single tree, 0 in case of success
+ */
+int init_tree(struct maze_tree* t, struct maze* m) {
+    uint32_t*   queue;      // nodes in breadth-first order
+    size_t      n, head, tail;
+    uint32_t    v, u, p, x, y;
+    int         code, dir, roots = 0;
+
+    t->m = m;
+    t->rows = m->height > 2 ? (m->height - 1) / 2 : 0;
+    t->cols = m->width > 2 ? (m->width - 1) / 2 : 0;
+    n = (size_t)t->rows * t->cols;
+    if (n == 0 || n > UINT32_MAX)
+        return -1;
+
+    t->parent = malloc(n * sizeof(uint32_t));
+    t->jump = malloc(n * sizeof(uint32_t));
+    t->depth = malloc(n * sizeof(uint32_t));
+    queue = malloc(n * sizeof(uint32_t));
+
+    // out of memory
+    if (t->parent == NULL || t->jump == NULL || t->depth == NULL || queue == NULL) {
+        free(queue);
+        free_tree(t);
+        return -1;
+    }
+
+    // the parent of each node is written into its block
+    for (v = 0; v < n; v++) {
+        x = 2 * (v / t->cols) + 1;
+        y = 2 * (v % t->cols) + 1;
+        code = (CELL(m, x, y) & CELL_PARENT) >> PARENT_SHIFT;
+        if (code == PARENT_ROOT) {
+            t->parent[v] = t->root = v;
+            roots++;
+        } else if (code != PARENT_NONE) {
+            t->parent[v] = node_at(t, x + 2 * step_x[code - 1], y + 2 * step_y[code - 1]);
+        } else {
+            roots = -1;
+            break;
+        }
+    }
+
+    // the depth and the jump of a node need the ones of its parent,
+    // so the nodes are visited from the root down
+    head = tail = 0;
+    if (roots == 1) {
+        t->depth[t->root] = 0;
+        t->jump[t->root] = t->root;
+        queue[tail++] = t->root;
+    }
+    while (head < tail) {
+        p = queue[head++];
+        x = 2 * (p / t->cols) + 1;
+        y = 2 * (p % t->cols) + 1;
+
+        for (dir = 0; dir < 4; dir++) {
+            // the child is 2 blocks away, the passage must be open
+            if ((dir == 0 && x + 2 >= m->height) || (dir == 1 && y + 2 >= m->width) ||
+                (dir == 2 && x < 2) || (dir == 3 && y < 2))
+                continue;
+            if (CELL(m, x + step_x[dir], y + step_y[dir]) & CELL_WALL)
+                continue;
+            u = node_at(t, x + 2 * step_x[dir], y + 2 * step_y[dir]);
+            if (u == p || t->parent[u] != p)
+                continue;
+
+            // jump twice as far as the parent does when its jumps
+            // have the same length, otherwise jump to the parent
+            t->depth[u] = t->depth[p] + 1;
+            v = t->jump[p];
+            if (t->depth[p] - t->depth[v] == t->depth[v] - t->depth[t->jump[v]])
+                t->jump[u] = t->jump[v];
+            else
+                t->jump[u] = p;
+            queue[tail++] = u;
+        }
+    }
+
+    free(queue);
+
+    // some nodes are not reachable from the root
+    if (tail != n) {
+        free_tree(t);
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * Free the memory allocated for the tree
+ *
+ * [IN]     maze_tree*: pointer to the tree struct
+ * [OUT]    void
+ */
+void free_tree(struct maze_tree* t) {
+    free(t->parent);
+    free(t->jump);
+    free(t->depth);
+    t->parent = t->jump = t->depth = NULL;
+}
+
+/**
+ * Find the lowest common ancestor of two nodes in O(log n)
+ *
+ * [IN]     maze_tree*: pointer to the tree struct
+ * [IN]     uint32_t: first node
+ * [IN]     uint32_t: second node
+ * [OUT]    uint32_t: their lowest common ancestor
+ */
+uint32_t tree_lca(struct maze_tree* t, uint32_t a, uint32_t b) {
+    uint32_t c;
+
+    // a is the deepest one
+    if (t->depth[a] < t->depth[b]) {
+        c = a;
+        a = b;
+        b = c;
+    }
+
+    // bring a up to the depth of b
+    while (t->depth[a] > t->depth[b]) {
+        if (t->depth[t->jump[a]] >= t->depth[b])
+            a = t->jump[a];
+        else
+            a = t->parent[a];
+    }
+
+    // at the same depth the jumps have the same length
+    while (a != b) {
+        if (t->jump[a] != t->jump[b]) {
+            a = t->jump[a];
+            b = t->jump[b];
+        } else {
+            a = t->parent[a];
+            b = t->parent[b];
+        }
+    }
+
+    return a;
+}
+
+/**
+ * Length of the path between two free blocks of the tree (nodes or
+ * passages between them), in blocks walked
+ *
+ * [IN]     maze_tree*: pointer to the tree struct
+ * [IN]     uint32_t: first block position (x, y)
+ * [IN]     uint32_t: second block position (x, y)
+ * [OUT]    long: length of the path, -1 if a block is not in the tree
+ */
+long tree_distance(struct maze_tree* t, uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1) {
+    uint32_t best[3];
+
+    return closest_ends(t, x0, y0, x1, y1, best);
+}
+
+/**
+ * Path between two free blocks of the tree, as the indexes (x * width + y)
+ * of its blocks from the first to the second one
+ *
+ * [IN]     maze_tree*: pointer to the tree struct
+ * [IN]     uint32_t: first block position (x, y)
+ * [IN]     uint32_t: second block position (x, y)
+ * [IN]     uint32_t*: the path will be left here, it must have room for
+ *                     tree_distance() + 1 blocks
+ * [OUT]    long: blocks of the path, -1 if a block is not in the tree
+ */
+long tree_path(struct maze_tree* t, uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1,
+        uint32_t* path) {
+    uint32_t    best[3];    // closest ends and their ancestor
+    uint32_t    width = t->m->width;
+    uint32_t    v;
+    long        k = 0, end;
+
+    if (closest_ends(t, x0, y0, x1, y1, best) < 0)
+        return -1;
+    if (x0 == x1 && y0 == y1) {
+        path[0] = x0 * width + y0;
+        return 1;
+    }
+
+    // the first block, when it is a passage
+    if (x0 % 2 == 0 || y0 % 2 == 0)
+        path[k++] = x0 * width + y0;
+
+    // up from the first end to the ancestor, each node followed
+    // by the passage towards its parent
+    for (v = best[0]; v != best[2]; v = t->parent[v]) {
+        path[k++] = block_of(t, v);
+        path[k++] = (block_of(t, v) + block_of(t, t->parent[v])) / 2;
+    }
+    path[k++] = block_of(t, best[2]);
+
+    // then down to the second end, filled from the bottom
+    end = k + 2 * (long)(t->depth[best[1]] - t->depth[best[2]]);
+    k = end;
+    for (v = best[1]; v != best[2]; v = t->parent[v]) {
+        path[--k] = block_of(t, v);
+        path[--k] = (block_of(t, v) + block_of(t, t->parent[v])) / 2;
+    }
+    k = end;
+
+    // the last block, when it is a passage
+    if (x1 % 2 == 0 || y1 % 2 == 0)
+        path[k++] = x1 * width + y1;
+
+    return k;
+}
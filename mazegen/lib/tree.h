@@ -0,0 +1,111 @@
+/**
+ * TREE
+ * Ancestors of the spanning tree of a perfect maze, so that
+ * distances and paths are found without any search
+ *
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2018, Gabriele Ara, Gabriele Serra
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef TREE_H
+#define TREE_H
+
+#include "maze.h"
+
+/**
+ * STRUCT MAZE_TREE
+ * Spanning tree built by the generator from the parent of each node.
+ * Besides its parent, each node keeps its depth and a jump pointer to
+ * an ancestor: following jumps and parents any ancestor is reached in
+ * O(log n) steps, with O(1) memory for each node. Node (x, y) of the
+ * maze is the node ((x - 1) / 2) * cols + (y - 1) / 2 of the tree
+ */
+struct maze_tree {
+    struct maze*    m;          // the maze
+    uint32_t*       parent;     // parent of each node (the root is its own parent)
+    uint32_t*       jump;       // farther ancestor of each node
+    uint32_t*       depth;      // distance of each node from the root
+    uint32_t        rows;       // nodes for each column
+    uint32_t        cols;       // nodes for each row
+    uint32_t        root;       // root of the tree
+};
+
+/**
+ * Build the tree of a maze created by create_maze or create_maze_tiled.
+ * The maze can't change until the tree is freed
+ * 
+ * [IN]     maze_tree*: pointer to the tree to be initialized
+ * [IN]     maze*: pointer to the maze struct
+ * [OUT]    int: -1 in case of low mem availability or if the maze is not
+ *               a single tree, 0 in case of success
+ */
+int init_tree(struct maze_tree* t, struct maze* m);
+
+/**
+ * Free the memory allocated for the tree
+ * 
+ * [IN]     maze_tree*: pointer to the tree struct
+ * [OUT]    void
+ */
+void free_tree(struct maze_tree* t);
+
+/**
+ * Find the lowest common ancestor of two nodes in O(log n)
+ * 
+ * [IN]     maze_tree*: pointer to the tree struct
+ * [IN]     uint32_t: first node
+ * [IN]     uint32_t: second node
+ * [OUT]    uint32_t: their lowest common ancestor
+ */
+uint32_t tree_lca(struct maze_tree* t, uint32_t a, uint32_t b);
+
+/**
+ * Length of the path between two free blocks of the tree (nodes or
+ * passages between them), in blocks walked
+ * 
+ * [IN]     maze_tree*: pointer to the tree struct
+ * [IN]     uint32_t: first block position (x, y)
+ * [IN]     uint32_t: second block position (x, y)
+ * [OUT]    long: length of the path, -1 if a block is not in the tree
+ */
+long tree_distance(struct maze_tree* t, uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1);
+
+/**
+ * Path between two free blocks of the tree, as the indexes (x * width + y)
+ * of its blocks from the first to the second one
+ * 
+ * [IN]     maze_tree*: pointer to the tree struct
+ * [IN]     uint32_t: first block position (x, y)
+ * [IN]     uint32_t: second block position (x, y)
+ * [IN]     uint32_t*: the path will be left here, it must have room for
+ *                     tree_distance() + 1 blocks
+ * [OUT]    long: blocks of the path, -1 if a block is not in the tree
+ */
+long tree_path(struct maze_tree* t, uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1,
+        uint32_t* path);
+
+
+#endif
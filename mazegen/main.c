@@ -4,7 +4,9 @@
  * that can be used as world for Gazebo simulator.
  * 
  * Compile: make
- * Usage: ./main <rows> <column>
+ * Usage: ./main [--merge] [--static] [--mesh] [--compact] [--stream] [--seed <seed>] [--threads <n>]
+ *              [--draw <format>] [--save] [--count <n> --out <dir>] <rows> <column>
+ *        ./main [--merge] [--static] [--mesh] [--compact] [--draw <format>] --load <file>
  *
  * BSD 2-Clause License
  *
@@ -35,15 +37,29 @@
 
 #include "lib/sdfparser.h"
 #include "lib/maze.h"
+#include "lib/render.h"
+#include "lib/mazefile.h"
+#include "lib/mesh.h"
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#include <getopt.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <errno.h>
+#include <limits.h>
+#include <sys/stat.h>
 
 // ----------------------------
 // STRING LENGTH
 // ---------------------------.
 
 #define MAX_POSE_LEN    30
-#define MAX_NAME_LEN    20
+#define MAX_NAME_LEN    40
+#define MAX_SIZE_LEN    48
+#define MAX_QUERY_LEN   64
+#define MAX_PATH_LEN    4096
 
 // ------------------------------------
 // MAIN SDF COMPONENT PATH AND SETTINGS
@@ -52,6 +68,12 @@
 #define WORLD_FILE      "sdf-element/world.sdf"
 #define BOX_FILE        "sdf-element/box.sdf"
 #define BOX_DIM         0.5
+#define MODEL_NAME      "'Maze'"
+#define WORLD_OUT       "maze.world"
+#define WORLD_EXT       ".world"
+#define MAZE_EXT        ".maze"
+#define MESH_EXT        ".stl"
+#define MANIFEST_FILE   "manifest.csv"
 
 // ----------------------------
 // ADDITIONAL SDF COMPONENT
@@ -64,13 +86,170 @@
 #define PHYSICS_FILE    "sdf-element/physics.sdf"
 char* names[NUM_FILES] = {LIGHT_FILE, GUI_FILE, GROUND_FILE, PHYSICS_FILE};
 
+// ----------------------------
+// COMMAND LINE OPTIONS
+// ---------------------------.
+
+struct option options[] = {
+    {"merge",   no_argument,    NULL,   'm'},
+    {"static",  no_argument,    NULL,   'a'},
+    {"mesh",    no_argument,    NULL,   'e'},
+    {"compact", no_argument,    NULL,   'c'},
+    {"stream",  no_argument,    NULL,   't'},
+    {"seed",    required_argument, NULL, 's'},
+    {"threads", required_argument, NULL, 'j'},
+    {"count",   required_argument, NULL, 'n'},
+    {"out",     required_argument, NULL, 'o'},
+    {"draw",    required_argument, NULL, 'd'},
+    {"save",    no_argument,    NULL,   'v'},
+    {"load",    required_argument, NULL, 'l'},
+    {NULL,      0,              NULL,   0}
+};
+
 /**
- * Print the message and return the retval
- * [IN] message: message to be terminal-printed
- * [IN] retval: value to be returned to system
+ * STRUCT BOX_SHAPE
+ * Visual or collision element of the box template and the
+ * strings that change when it is written into the maze model
+ */
+struct box_shape {
+    sdf_index           element;        // visual or collision element
+    struct sdf_string*  name;           // name attribute
+    struct sdf_string*  pose;           // pose content
+    struct sdf_string*  size;           // box size content
+    sdf_index           geometry;       // geometry element
+};
+
+/**
+ * STRUCT BOX_TEMPLATE
+ * Parsed box template and the strings that change for
+ * each box written from it
+ */
+struct box_template {
+    struct sdf_file     file;           // box template file
+    struct sdf_document document;       // box template document
+    struct sdf_string*  name;           // model name attribute
+    struct sdf_string*  pose;           // model pose content
+    sdf_index           link;           // link element
+    struct box_shape    visual;         // visual of the link
+    struct box_shape    collision;      // collision of the link
+};
+
+/**
+ * STRUCT TEMPLATES
+ * All the parsed templates needed to write a world. They are
+ * only read while writing, so more worlds can be written at once
+ */
+struct templates {
+    struct sdf_file         world_f;                // world template file
+    struct sdf_document     world_d;                // world template document
+    struct sdf_file         files[NUM_FILES];       // basic sdf-element files
+    struct sdf_document     documents[NUM_FILES];   // basic sdf-element documents
+    struct box_template     box;                    // box template
+};
+
+/**
+ * STRUCT SETTINGS
+ * How mazes are generated and written
+ */
+struct settings {
+    uint32_t                width;      // maze width
+    uint32_t                height;     // maze height
+    int                     merge;      // 1 to merge adjacent walls
+    int                     single;     // 1 to write the walls into one static model
+    int                     mesh;       // 1 to write the walls as a mesh of that model
+    int                     compact;    // 1 to write without indentation
+    int                     stream;     // 1 to generate row by row
+    int                     threads;    // threads of the generator, 0 for the sequential one
+    enum render_format      draw;       // format of the drawing of the maze
+    int                     save;       // 1 to save the maze next to the world
+    struct maze_file*       load;       // file of the maze, NULL to generate it
+};
+
+/**
+ * STRUCT ROW_WRITER
+ * Emitter that writes the walls of each row produced
+ * by the streaming generator
+ */
+struct row_writer {
+    struct sdf_writer*      w;          // writer of the world
+    struct box_template*    box;        // box template
+    int                     merge;      // 1 to merge adjacent walls of the row
+    int                     single;     // 1 to write the walls into one static model
+    struct renderer*        r;          // drawing of the rows, NULL if not drawn
+    struct maze_file*       f;          // file of the rows, NULL if not saved
+    struct mesh*            mesh;       // mesh of the rows, NULL if boxes are written
+    long                    boxes;      // boxes written
+};
+
+/**
+ * STRUCT BATCH_JOB
+ * Mazes of a batch shared among the threads that write them
+ */
+struct batch_job {
+    struct templates*       t;          // parsed templates
+    struct settings*        s;          // settings of each maze
+    char*                   dir;        // output directory
+    uint64_t                seed;       // seed of the first maze
+    size_t                  count;      // number of mazes
+    size_t                  next;       // next maze to be written (atomic)
+    long*                   boxes;      // boxes written for each maze
+};
+
+/**
+ * Parse all the templates once
+ * [IN] struct templates*: templates to be loaded
  * [OUT] void
  **/
-void build_world(struct sdf_document* world_d);
+void load_templates(struct templates* t);
+
+/**
+ * Free the memory allocated for the templates
+ * [IN] struct templates*: templates to be freed
+ * [OUT] void
+ **/
+void free_templates(struct templates* t);
+
+/**
+ * Write the beginning of the world: the root and the world tag of
+ * the world template followed by the basic sdf-elements. The world
+ * tag is left open
+ * [IN] struct sdf_writer*: writer in which write the world
+ * [IN] struct templates*: parsed templates
+ * [OUT] void
+ **/
+void build_world(struct sdf_writer* w, struct templates* t);
+
+/**
+ * Generate a maze and write its world into a file
+ * [IN] struct templates*: parsed templates
+ * [IN] struct settings*: how the maze is generated and written
+ * [IN] char*: name of the world file
+ * [IN] uint64_t: seed of the maze
+ * [OUT] long: number of boxes written
+ **/
+long write_world(struct templates* t, struct settings* s, char* filename, uint64_t seed);
+
+/**
+ * Write the worlds of a batch until all of them are taken
+ * [IN] void*: the batch job
+ * [OUT] void*: NULL
+ **/
+void* batch_worker(void* arg);
+
+/**
+ * Generate count mazes with consecutive seeds using a pool of threads.
+ * Each world is written into its own file of the output directory,
+ * together with a manifest that lists file, seed and size of each maze
+ * [IN] struct templates*: parsed templates
+ * [IN] struct settings*: how the mazes are generated and written
+ * [IN] char*: output directory
+ * [IN] uint64_t: seed of the first maze
+ * [IN] size_t: number of mazes
+ * [IN] int: number of threads
+ * [OUT] void
+ **/
+void run_batch(struct templates* t, struct settings* s, char* dir, uint64_t seed,
+        size_t count, int threads);
 
 /**
  * Print the message and return the retval
@@ -81,78 +260,233 @@ void build_world(struct sdf_document* world_d);
 void print_and_die(char* message, int retval);
 
 /**
- * Search for a tag and replace its content
- * [IN] struct sdf_element*: pointer to element in which search
- * [IN] char*: tag name
- * [IN] char*: new tag content
+ * Run a path query (e.g. "model/link") and return the element it matches
+ * [IN] struct sdf_document*: document that contains the element
+ * [IN] sdf_index: element in which search (and its siblings)
+ * [IN] char*: query path
+ * [OUT] sdf_index: the element
+ **/
+sdf_index search_element(struct sdf_document* d, sdf_index elem, char* path);
+
+/**
+ * Run a path query (e.g. "model/@name") and return the string it selects
+ * [IN] struct sdf_document*: document that contains the element
+ * [IN] sdf_index: element in which search (and its siblings)
+ * [IN] char*: query path
+ * [OUT] struct sdf_string*: the tag content or the attribute value
+ **/
+struct sdf_string* search_string(struct sdf_document* d, sdf_index elem, char* path);
+
+/**
+ * Search for a link sub-element and the strings that change when it
+ * is written into the maze model
+ * [IN] struct sdf_document*: document that contains the element
+ * [IN] sdf_index: the link element
+ * [IN] char*: name of the sub-element (visual or collision)
+ * [IN] struct box_shape*: the sub-element will be left here
  * [OUT] void
  **/
-void search_n_replace_cont(struct sdf_element* elem, char* tag, char* content);
+void search_shape(struct sdf_document* d, sdf_index link, char* tag, struct box_shape* shape);
 
 /**
- * Search for a tag, its attribute name and substitute its value
- * [IN] struct sdf_element*: pointer to element in which search
- * [IN] char*: tag name
- * [IN] char*: attribute name
- * [IN] char*: new value
+ * Parse the box template and find the strings that change for each box
+ * [IN] struct box_template*: template to be loaded
  * [OUT] void
  **/
-void search_n_replace_attr(struct sdf_element* elem, char* tag, char* name, char* value);
+void load_box(struct box_template* box);
 
 /**
- * Build a box and add it to the world
- * [IN] message: message to be terminal-printed
- * [IN] retval: value to be returned to system
+ * Open the static model that holds all the walls of the maze, together
+ * with its only link. The link is left open
+ * [IN] struct sdf_writer*: writer of the world
+ * [IN] struct box_template*: box template
  * [OUT] void
  **/
-void add_box(struct sdf_document* world, int box_id, float x, float y, float z);
+void open_maze_model(struct sdf_writer* w, struct box_template* box);
 
 /**
- * Generate a maze and print onto screen
- * [IN] struct maze*: maze will be stored here
+ * Close the link and the static model of the maze
+ * [IN] struct sdf_writer*: writer of the world
+ * [OUT] void
+ **/
+void close_maze_model(struct sdf_writer* w);
+
+/**
+ * Write a visual or a collision of the box template whose geometry is
+ * a mesh instead of a box
+ * [IN] struct sdf_writer*: writer of the world
+ * [IN] struct sdf_document*: box template document
+ * [IN] struct box_shape*: visual or collision of the template
+ * [IN] char*: uri of the mesh
+ * [OUT] void
+ **/
+void add_mesh(struct sdf_writer* w, struct sdf_document* d, struct box_shape* shape, char* uri);
+
+/**
+ * Write a box from the template into the world: a model of its own, or
+ * a visual and a collision of the link of the maze model
+ * [IN] struct sdf_writer*: writer of the world
+ * [IN] struct box_template*: box template
+ * [IN] int: 1 to write the box into the maze model
+ * [IN] size_t: box identifier
+ * [IN] float: x, y, z position of the box center
+ * [IN] float: dx, dy, dz box size
+ * [OUT] void
+ **/
+void add_box(struct sdf_writer* w, struct box_template* box, int single, size_t box_id,
+        float x, float y, float z, float dx, float dy, float dz);
+
+/**
+ * Write a box for each wall block of the maze
+ * [IN] struct sdf_writer*: writer of the world
+ * [IN] struct box_template*: box template
+ * [IN] int: 1 to write the boxes into the maze model
+ * [IN] struct maze*: maze to be converted
+ * [OUT] long: number of boxes written
+ **/
+long add_walls(struct sdf_writer* w, struct box_template* box, int single, struct maze* m);
+
+/**
+ * Merge adjacent wall blocks of the maze and write a box for each rectangle
+ * [IN] struct sdf_writer*: writer of the world
+ * [IN] struct box_template*: box template
+ * [IN] int: 1 to write the boxes into the maze model
+ * [IN] struct maze*: maze to be converted
+ * [OUT] long: number of boxes written
+ **/
+long add_merged_walls(struct sdf_writer* w, struct box_template* box, int single, struct maze* m);
+
+/**
+ * Draw a row of the streaming generator and write its walls, merging
+ * adjacent walls of the row if requested
+ * [IN] void*: the row writer
+ * [IN] uint32_t: row position in the maze (x position)
+ * [IN] uint8_t*: blocks of the row
+ * [IN] uint32_t: number of blocks in the row
+ * [OUT] void
+ **/
+void add_row_walls(void* data, uint32_t x, uint8_t* row, uint32_t width);
+
+/**
+ * Read and check the maze size
  * [IN] char* w_str: must contain width in string version
  * [IN] char* h_str: must contain height in string version
+ * [IN] uint32_t*: width will be left here
+ * [IN] uint32_t*: height will be left here
  * [OUT] void
  **/
-void generate_maze(struct maze* m, char* w_str, char* h_str);
+void read_size(char* w_str, char* h_str, uint32_t* width, uint32_t* height);
+
+/**
+ * Generate a maze, or load it from its file
+ * [IN] struct maze*: maze will be stored here
+ * [IN] struct settings*: how the maze is generated
+ * [IN] uint64_t: seed of the maze
+ * [OUT] void
+ **/
+void generate_maze(struct maze* m, struct settings* s, uint64_t seed);
 
 int main(int argc, char* argv[]) {
-    struct sdf_file world_f;
-    struct sdf_document world_d;
-    struct maze m;    
-    int i, j;
+    struct templates    t;
+    struct settings     s = {0};
+    struct maze_file    f;
+    uint64_t seed = time(NULL);
+    size_t count = 0;
+    char* dir = NULL;
+    char* end;
+    int opt;
+
+    // parse options
+    while ((opt = getopt_long(argc, argv, "maects:j:n:o:d:vl:", options, NULL)) != -1) {
+        switch (opt) {
+            case 'm':
+                s.merge = 1;
+                break;
+            case 'a':
+                s.single = 1;
+                break;
+            case 'e':
+                // the mesh is the only shape of the static model
+                s.single = 1;
+                s.mesh = 1;
+                break;
+            case 'c':
+                s.compact = 1;
+                break;
+            case 't':
+                s.stream = 1;
+                break;
+            case 'j':
+                s.threads = strtol(optarg, &end, 10);
+                if (*optarg == '\0' || *end != '\0' || s.threads < 1)
+                    print_and_die("Invalid number of threads provided.", -1);
+                break;
+            case 's':
+                seed = strtoull(optarg, &end, 10);
+                if (*optarg == '\0' || *end != '\0')
+                    print_and_die("Invalid seed provided.", -1);
+                break;
+            case 'n':
+                count = strtoull(optarg, &end, 10);
+                if (*optarg == '\0' || *end != '\0' || count < 1)
+                    print_and_die("Invalid count provided.", -1);
+                break;
+            case 'o':
+                dir = optarg;
+                break;
+            case 'd':
+                s.draw = render_parse(optarg);
+                if (s.draw == RENDER_NONE)
+                    print_and_die("Invalid drawing format provided.", -1);
+                break;
+            case 'v':
+                s.save = 1;
+                break;
+            case 'l':
+                if (open_maze_file(&f, optarg))
+                    print_and_die("Invalid maze file provided.", -1);
+                s.load = &f;
+                break;
+            default:
+                exit(-1);
+        }
+    }
 
     // usage infos
-    if (argc < 3) {
-        printf("Usage: %s <rows> <column>\n", argv[0]);
+    if ((s.load == NULL && argc - optind < 2) || (count > 0) != (dir != NULL) ||
+            (s.load != NULL && count > 0)) {
+        printf("Usage: %s [--merge] [--static] [--mesh] [--compact] [--stream] [--seed <seed>]\n"
+               "       [--threads <n>] [--draw <format>] [--save] [--count <n> --out <dir>] <rows> <column>\n"
+               "       %s [--merge] [--static] [--mesh] [--compact] [--draw <format>] --load <file>\n",
+               argv[0], argv[0]);
         exit(-1);
     }
-	
-    // open world file and parse it
-    sdf_file_open(&world_f, WORLD_FILE);    
-    sdf_document_create(&world_f, &world_d);
 
-    // build the world using basic sdf-elements
-    build_world(&world_d);
+    // size and seed of a saved maze are in its file
+    if (s.load != NULL) {
+        s.width = f.header->width;
+        s.height = f.header->height;
+        seed = f.header->seed;
+    } else {
+        read_size(argv[optind], argv[optind + 1], &s.width, &s.height);
+    }
 
-    // generate the maze
-    generate_maze(&m, argv[1], argv[2]);
+    // parse the templates once, they will be written for each world
+    load_templates(&t);
 
-    // for each block of the maze, add a box into the 3D world
-    for (i = 0; i < m.height; i++) {
-		for (j = 0; j < m.width; j++)
-            if(m.graph[i * m.width + j].type == WALL) {
-                if(!((i == 0 && j == 0) || (i == 1 && j == 0)))
-                    add_box(&world_d, i*m.width+j, i * BOX_DIM , j * BOX_DIM , 0);
-            }
+    if (count > 0) {
+        // many mazes, each one into its own file
+        run_batch(&t, &s, dir, seed, count, s.threads ? s.threads : sysconf(_SC_NPROCESSORS_ONLN));
+    } else {
+        // a single maze, drawn if requested
+        write_world(&t, &s, WORLD_OUT, seed);
+        fprintf(stderr, "Seed: %llu\n", (unsigned long long)seed);
     }
-    
-    // export the document to file
-    sdf_document_print(&world_d, "maze.world");
-    
+
     // free memory
-    sdf_document_close(&world_d);
-    sdf_file_close(&world_f);
+    free_templates(&t);
+    if (s.load != NULL)
+        close_maze_file(&f);
 
     // everything ok
     return 0;
@@ -170,144 +504,654 @@ void print_and_die(char* message, int retval) {
 }
 
 /**
- * Search for a tag and replace its content
- * [IN] struct sdf_element*: pointer to element in which search
- * [IN] char*: tag name
- * [IN] char*: new tag content
- * [OUT] void
+ * Run a path query (e.g. "model/link") and return the element it matches
+ * [IN] struct sdf_document*: document that contains the element
+ * [IN] sdf_index: element in which search (and its siblings)
+ * [IN] char*: query path
+ * [OUT] sdf_index: the element
  **/
-void search_n_replace_cont(struct sdf_element* elem, char* tag, char* content) {
-    struct sdf_element* e;  // will contain the tag found
-	
-    // search the tag
-    e = sdf_element_search(elem, tag);
+sdf_index search_element(struct sdf_document* d, sdf_index elem, char* path) {
+    struct sdf_query    q;
+    sdf_index           e;  // will contain the tag found
+
+    if(sdf_query_compile(&q, path))
+        print_and_die("Invalid query path.", -1);
+    e = sdf_query_run(&q, d, elem);
+    sdf_query_free(&q);
 
     // die if not found (fatal error)
-    if(e == NULL)
+    if(e == SDF_NONE)
         print_and_die("Unable to find request tag.", -1);
-    
-    // replace the string
-    sdf_replace_string(e->content, content);
+
+    return e;
 }
 
 /**
- * Search for a tag, its attribute name and substitute its value
- * [IN] struct sdf_element*: pointer to element in which search
- * [IN] char*: tag name
- * [IN] char*: attribute name
- * [IN] char*: new value
- * [OUT] void
+ * Run a path query (e.g. "model/@name") and return the string it selects
+ * [IN] struct sdf_document*: document that contains the element
+ * [IN] sdf_index: element in which search (and its siblings)
+ * [IN] char*: query path
+ * [OUT] struct sdf_string*: the tag content or the attribute value
  **/
-void search_n_replace_attr(struct sdf_element* elem, char* tag, char* name, char* value) {
-    struct sdf_element*     e;  // will contain the tag found
-    struct sdf_attribute*   a;  // will contain the attribute found
-	
-    // search the tag
-    e = sdf_element_search(elem, tag);
+struct sdf_string* search_string(struct sdf_document* d, sdf_index elem, char* path) {
+    struct sdf_query    q;
+    struct sdf_string*  s;  // will contain the string found
+
+    if(sdf_query_compile(&q, path))
+        print_and_die("Invalid query path.", -1);
+    s = sdf_query_string(&q, d, elem);
+    sdf_query_free(&q);
 
     // die if not found (fatal error)
-    if(e == NULL)
-        print_and_die("Unable to find request tag.", -1);
+    if(s == NULL)
+        print_and_die("Unable to find request tag or attribute.", -1);
 
-    a = sdf_attribute_search(e->attributes, name);
+    return s;
+}
 
-    // die if not found (fatal error)
-    if(a == NULL)
-        print_and_die("Unable to find request attribute.", -1);
-    
-    // replace the string
-    sdf_replace_string(a->value, value);
+/**
+ * Search for a link sub-element and the strings that change when it
+ * is written into the maze model
+ * [IN] struct sdf_document*: document that contains the element
+ * [IN] sdf_index: the link element
+ * [IN] char*: name of the sub-element (visual or collision)
+ * [IN] struct box_shape*: the sub-element will be left here
+ * [OUT] void
+ **/
+void search_shape(struct sdf_document* d, sdf_index link, char* tag, struct box_shape* shape) {
+    sdf_index   children = sdf_element_get(d, link)->children;
+    char        path[MAX_QUERY_LEN];
+
+    shape->element = search_element(d, children, tag);
+    snprintf(path, MAX_QUERY_LEN, "%s/@name", tag);
+    shape->name = search_string(d, children, path);
+    snprintf(path, MAX_QUERY_LEN, "%s/pose", tag);
+    shape->pose = search_string(d, children, path);
+    snprintf(path, MAX_QUERY_LEN, "%s/geometry/box/size", tag);
+    shape->size = search_string(d, children, path);
+    snprintf(path, MAX_QUERY_LEN, "%s/geometry", tag);
+    shape->geometry = search_element(d, children, path);
 }
 
 /**
- * Print the message and return the retval
- * [IN] message: message to be terminal-printed
- * [IN] retval: value to be returned to system
+ * Parse all the templates once
+ * [IN] struct templates*: templates to be loaded
  * [OUT] void
  **/
-void build_world(struct sdf_document* world) {
-    // files list
-    int                 i;
-    struct sdf_file     files[NUM_FILES];
-    struct sdf_document documents[NUM_FILES];
+void load_templates(struct templates* t) {
+    int i;
+
+    // open world file and parse it
+    if(sdf_file_open(&t->world_f, WORLD_FILE))
+        print_and_die("Unable to open world template.", -1);
+    sdf_document_create(&t->world_f, &t->world_d);
 
-    // for each files, open file, create document and append it to world
+    // basic sdf-elements
     for(i = 0; i < NUM_FILES; i++) {
-        sdf_file_open(&files[i], names[i]);
-        sdf_document_create(&files[i], &documents[i]);
-        sdf_element_append(&world->root->children, documents[i].root);
+        if(sdf_file_open(&t->files[i], names[i]))
+            print_and_die("Unable to open sdf-element file.", -1);
+        sdf_document_create(&t->files[i], &t->documents[i]);
     }
+
+    load_box(&t->box);
 }
 
 /**
- * Build a box and add it to the world
- * [IN] message: message to be terminal-printed
- * [IN] retval: value to be returned to system
+ * Free the memory allocated for the templates
+ * [IN] struct templates*: templates to be freed
+ * [OUT] void
+ **/
+void free_templates(struct templates* t) {
+    int i;
+
+    sdf_document_close(&t->box.document);
+    sdf_file_close(&t->box.file);
+    for(i = 0; i < NUM_FILES; i++) {
+        sdf_document_close(&t->documents[i]);
+        sdf_file_close(&t->files[i]);
+    }
+    sdf_document_close(&t->world_d);
+    sdf_file_close(&t->world_f);
+}
+
+/**
+ * Write the beginning of the world: the root and the world tag of
+ * the world template followed by the basic sdf-elements. The world
+ * tag is left open
+ * [IN] struct sdf_writer*: writer in which write the world
+ * [IN] struct templates*: parsed templates
+ * [OUT] void
+ **/
+void build_world(struct sdf_writer* w, struct templates* t) {
+    struct sdf_document*    world_d = &t->world_d;
+    struct sdf_document*    d;
+    sdf_index               world;
+    sdf_index               e;
+    int                     i;
+
+    // the world tag is the first child of the root
+    world = sdf_element_get(world_d, world_d->root)->children;
+    if(world == SDF_NONE)
+        print_and_die("Unable to find world tag.", -1);
+
+    // open root and world, then copy what the template already contains
+    sdf_writer_template_open(w, world_d, world_d->root);
+    sdf_writer_template_open(w, world_d, world);
+    for(e = sdf_element_get(world_d, world)->children; e != SDF_NONE;
+            e = sdf_element_get(world_d, e)->sibling)
+        sdf_writer_template(w, world_d, e, NULL, 0);
+
+    // for each files, write its top-level elements (root and siblings)
+    // into the world
+    for(i = 0; i < NUM_FILES; i++) {
+        d = &t->documents[i];
+        for(e = d->root; e != SDF_NONE; e = sdf_element_get(d, e)->sibling)
+            sdf_writer_template(w, d, e, NULL, 0);
+    }
+}
+
+/**
+ * Generate a maze and write its world into a file
+ * [IN] struct templates*: parsed templates
+ * [IN] struct settings*: how the maze is generated and written
+ * [IN] char*: name of the world file
+ * [IN] uint64_t: seed of the maze
+ * [OUT] long: number of boxes written
+ **/
+long write_world(struct templates* t, struct settings* s, char* filename, uint64_t seed) {
+    struct sdf_writer   w;
+    struct row_writer   rw;
+    struct renderer     r;
+    struct maze_file    f;
+    struct mesh         mesh;
+    struct maze         m;
+    char                base[MAX_PATH_LEN];
+    char                path[MAX_PATH_LEN];
+    char                mesh_path[MAX_PATH_LEN];
+    char                uri[MAX_PATH_LEN + PATH_MAX];
+    char                real[PATH_MAX];
+    size_t              len;
+    long                boxes;
+
+    // the world is written while it is built, it is never kept in memory
+    if(sdf_writer_open(&w, filename))
+        print_and_die("Unable to create the world file.", -1);
+    w.compact = s->compact;
+
+    // drawing and maze file are named after the world
+    len = strlen(filename);
+    if (len > strlen(WORLD_EXT) && !strcmp(filename + len - strlen(WORLD_EXT), WORLD_EXT))
+        len -= strlen(WORLD_EXT);
+    snprintf(base, MAX_PATH_LEN, "%.*s", (int)len, filename);
+    if (snprintf(path, MAX_PATH_LEN, "%.*s%s", (int)len, filename, MAZE_EXT) >= MAX_PATH_LEN ||
+            snprintf(mesh_path, MAX_PATH_LEN, "%.*s%s", (int)len, filename, MESH_EXT) >= MAX_PATH_LEN)
+        print_and_die("Invalid world file name.", -1);
+    if (s->draw != RENDER_NONE && render_open(&r, base, s->draw, s->width, s->height, BOX_DIM))
+        print_and_die("Unable to create the drawing.", -1);
+
+    // build the world using basic sdf-elements
+    build_world(&w, t);
+    if (s->single)
+        open_maze_model(&w, &t->box);
+
+    // the walls are written into the mesh, the world only refers to it
+    if (s->mesh) {
+        if (mesh_open(&mesh, mesh_path, s->width, s->height, BOX_DIM) ||
+                realpath(mesh_path, real) == NULL)
+            print_and_die("Unable to create the mesh.", -1);
+        snprintf(uri, sizeof(uri), "file://%s", real);
+        add_mesh(&w, &t->box.document, &t->box.visual, uri);
+        add_mesh(&w, &t->box.document, &t->box.collision, uri);
+    }
+
+    if (s->stream && s->load == NULL) {
+        // generate the maze row by row and write the walls of each row,
+        // the rows have no parents to be saved
+        if (s->save && create_maze_file(&f, path, s->width, s->height, seed, BOX_DIM, 0))
+            print_and_die("Unable to create the maze file.", -1);
+        rw.w = &w;
+        rw.box = &t->box;
+        rw.merge = s->merge;
+        rw.single = s->single;
+        rw.r = s->draw != RENDER_NONE ? &r : NULL;
+        rw.f = s->save ? &f : NULL;
+        rw.mesh = s->mesh ? &mesh : NULL;
+        rw.boxes = 0;
+        if (stream_maze(s->width, s->height, seed, add_row_walls, &rw))
+            print_and_die("Out of memory.", -1);
+        if (s->save && close_maze_file(&f))
+            print_and_die("Unable to write the maze file.", -1);
+        boxes = rw.boxes;
+    } else {
+        // generate the maze and draw it
+        generate_maze(&m, s, seed);
+        if (s->draw != RENDER_NONE)
+            render_maze(&r, &m);
+
+        // open the maze entrance
+        set_block(&m, 0, 0, NONE);
+        set_block(&m, 1, 0, NONE);
+
+        if (s->save && save_maze(&m, path, seed, BOX_DIM))
+            print_and_die("Unable to write the maze file.", -1);
+
+        // add the walls of the maze into the 3D world
+        if (s->mesh) {
+            mesh_maze(&mesh, &m);
+            boxes = 0;
+        } else if (s->merge)
+            boxes = add_merged_walls(&w, &t->box, s->single, &m);
+        else
+            boxes = add_walls(&w, &t->box, s->single, &m);
+
+        free_maze(&m);
+    }
+
+    if (s->mesh && mesh_close(&mesh))
+        print_and_die("Unable to write the mesh.", -1);
+    if (s->single)
+        close_maze_model(&w);
+
+    // close world and root tags and flush the file
+    if(sdf_writer_close(&w))
+        print_and_die("Unable to write the world file.", -1);
+    if (s->draw != RENDER_NONE && render_close(&r))
+        print_and_die("Unable to write the drawing.", -1);
+
+    return boxes;
+}
+
+/**
+ * Write the worlds of a batch until all of them are taken
+ * [IN] void*: the batch job
+ * [OUT] void*: NULL
+ **/
+void* batch_worker(void* arg) {
+    struct batch_job*   job = arg;
+    char                path[MAX_PATH_LEN];
+    size_t              i;
+
+    while ((i = __atomic_fetch_add(&job->next, 1, __ATOMIC_RELAXED)) < job->count) {
+        snprintf(path, MAX_PATH_LEN, "%s/maze_%zu.world", job->dir, i);
+        job->boxes[i] = write_world(job->t, job->s, path, job->seed + i);
+    }
+
+    return NULL;
+}
+
+/**
+ * Generate count mazes with consecutive seeds using a pool of threads.
+ * Each world is written into its own file of the output directory,
+ * together with a manifest that lists file, seed and size of each maze
+ * [IN] struct templates*: parsed templates
+ * [IN] struct settings*: how the mazes are generated and written
+ * [IN] char*: output directory
+ * [IN] uint64_t: seed of the first maze
+ * [IN] size_t: number of mazes
+ * [IN] int: number of threads
+ * [OUT] void
+ **/
+void run_batch(struct templates* t, struct settings* s, char* dir, uint64_t seed,
+        size_t count, int threads) {
+    struct batch_job    job;
+    struct settings     maze_s = *s;
+    pthread_t*          workers;
+    char                path[MAX_PATH_LEN];
+    FILE*               manifest;
+    size_t              i;
+    int                 started;
+
+    if (mkdir(dir, 0755) && errno != EEXIST)
+        print_and_die("Unable to create the output directory.", -1);
+
+    // each thread generates its own mazes sequentially, the
+    // drawings of different mazes can't share the terminal
+    maze_s.threads = 0;
+    if (maze_s.draw == RENDER_UNICODE || maze_s.draw == RENDER_ASCII)
+        maze_s.draw = RENDER_NONE;
+
+    job.t = t;
+    job.s = &maze_s;
+    job.dir = dir;
+    job.seed = seed;
+    job.count = count;
+    job.next = 0;
+    job.boxes = malloc(count * sizeof(long));
+    workers = malloc((threads > 1 ? threads - 1 : 1) * sizeof(pthread_t));
+    if (job.boxes == NULL || workers == NULL)
+        print_and_die("Out of memory.", -1);
+
+    // this thread works too, if a thread can't start the others do its work
+    for (started = 0; started < threads - 1; started++)
+        if (pthread_create(workers + started, NULL, batch_worker, &job) != 0)
+            break;
+    batch_worker(&job);
+    for (i = 0; i < (size_t)started; i++)
+        pthread_join(workers[i], NULL);
+
+    // list the worlds written
+    snprintf(path, MAX_PATH_LEN, "%s/%s", dir, MANIFEST_FILE);
+    manifest = fopen(path, "w");
+    if (manifest == NULL)
+        print_and_die("Unable to create the manifest.", -1);
+    fprintf(manifest, "file,seed,width,height,boxes\n");
+    for (i = 0; i < count; i++)
+        fprintf(manifest, "maze_%zu.world,%llu,%u,%u,%ld\n", i,
+                (unsigned long long)(seed + i), s->width, s->height, job.boxes[i]);
+    if (fclose(manifest))
+        print_and_die("Unable to write the manifest.", -1);
+
+    free(workers);
+    free(job.boxes);
+}
+
+/**
+ * Parse the box template and find the strings that change for each box
+ * [IN] struct box_template*: template to be loaded
+ * [OUT] void
+ **/
+void load_box(struct box_template* box) {
+    struct sdf_document*    d = &box->document;
+    sdf_index               model;
+    sdf_index               link;
+
+    if(sdf_file_open(&box->file, BOX_FILE))
+        print_and_die("Unable to open box template.", -1);
+    sdf_document_create(&box->file, d);
+    model = d->root;
+
+    // name and position of the model
+    box->name = search_string(d, model, "model/@name");
+    box->pose = search_string(d, model, "model/pose");
+
+    // geometry of both visual and collision
+    link = search_element(d, model, "model/link");
+    box->link = link;
+    search_shape(d, link, "visual", &box->visual);
+    search_shape(d, link, "collision", &box->collision);
+}
+
+/**
+ * Open the static model that holds all the walls of the maze, together
+ * with its only link. The link is left open
+ * [IN] struct sdf_writer*: writer of the world
+ * [IN] struct box_template*: box template
+ * [OUT] void
+ **/
+void open_maze_model(struct sdf_writer* w, struct box_template* box) {
+    sdf_writer_element_open(w, "model");
+    sdf_writer_attribute(w, "name", MODEL_NAME);
+
+    // a static model is never moved by the physics engine
+    sdf_writer_element_open(w, "static");
+    sdf_writer_text(w, "true");
+    sdf_writer_element_close(w);
+
+    // the link of the template, without inertia and shapes
+    sdf_writer_template_open(w, &box->document, box->link);
+}
+
+/**
+ * Close the link and the static model of the maze
+ * [IN] struct sdf_writer*: writer of the world
  * [OUT] void
  **/
-void add_box(struct sdf_document* world, int box_id, float x, float y, float z) {
-    struct sdf_file     box_f;
-    struct sdf_document box_d;
+void close_maze_model(struct sdf_writer* w) {
+    sdf_writer_element_close(w);
+    sdf_writer_element_close(w);
+}
+
+/**
+ * Write a visual or a collision of the box template whose geometry is
+ * a mesh instead of a box
+ * [IN] struct sdf_writer*: writer of the world
+ * [IN] struct sdf_document*: box template document
+ * [IN] struct box_shape*: visual or collision of the template
+ * [IN] char*: uri of the mesh
+ * [OUT] void
+ **/
+void add_mesh(struct sdf_writer* w, struct sdf_document* d, struct box_shape* shape, char* uri) {
+    sdf_index e;
+
+    sdf_writer_template_open(w, d, shape->element);
+    for(e = sdf_element_get(d, shape->element)->children; e != SDF_NONE;
+            e = sdf_element_get(d, e)->sibling) {
+        if(e != shape->geometry) {
+            sdf_writer_template(w, d, e, NULL, 0);
+            continue;
+        }
+
+        // the mesh is already placed in the world
+        sdf_writer_element_open(w, "geometry");
+        sdf_writer_element_open(w, "mesh");
+        sdf_writer_element_open(w, "uri");
+        sdf_writer_text(w, uri);
+        sdf_writer_element_close(w);
+        sdf_writer_element_close(w);
+        sdf_writer_element_close(w);
+    }
+    sdf_writer_element_close(w);
+}
+
+/**
+ * Write a box from the template into the world: a model of its own, or
+ * a visual and a collision of the link of the maze model
+ * [IN] struct sdf_writer*: writer of the world
+ * [IN] struct box_template*: box template
+ * [IN] int: 1 to write the box into the maze model
+ * [IN] size_t: box identifier
+ * [IN] float: x, y, z position of the box center
+ * [IN] float: dx, dy, dz box size
+ * [OUT] void
+ **/
+void add_box(struct sdf_writer* w, struct box_template* box, int single, size_t box_id,
+        float x, float y, float z, float dx, float dy, float dz) {
+    struct sdf_override o[6];
     char                pose[MAX_POSE_LEN];
     char                name[MAX_NAME_LEN];
+    char                shape[MAX_NAME_LEN];
+    char                size[MAX_SIZE_LEN];
+
+    // sprintf new position and size
+    snprintf(pose, MAX_POSE_LEN, "%.3f %.3f %.3f 0 0 0", x, y, z);
+    snprintf(size, MAX_SIZE_LEN, "%g %g %g", dx, dy, dz);
 
-    // open file and parse it
-    sdf_file_open(&box_f, BOX_FILE);
-    sdf_document_create(&box_f, &box_d);
+    if (single) {
+        // visual and collision are placed inside the link of the maze
+        snprintf(name, MAX_NAME_LEN, "'visual_%zu'", box_id);
+        snprintf(shape, MAX_NAME_LEN, "'collision_%zu'", box_id);
+        o[0].target = box->visual.name;
+        o[0].value = name;
+        o[1].target = box->visual.pose;
+        o[1].value = pose;
+        o[2].target = box->visual.size;
+        o[2].value = size;
+        o[3].target = box->collision.name;
+        o[3].value = shape;
+        o[4].target = box->collision.pose;
+        o[4].value = pose;
+        o[5].target = box->collision.size;
+        o[5].value = size;
+
+        sdf_writer_template(w, &box->document, box->visual.element, o, 3);
+        sdf_writer_template(w, &box->document, box->collision.element, o + 3, 3);
+        return;
+    }
 
-    // clean buffer and sprintf new position and name
-    memset(name, 0, MAX_NAME_LEN * sizeof(char));
-    memset(pose, 0, MAX_POSE_LEN * sizeof(char));
-    sprintf(name, "'Box_Red_%d'", box_id);
-    sprintf(pose, "%.3f %.3f %.3f 0 0 0", x, y, z);
+    // substitute name, position and geometry while writing the template
+    snprintf(name, MAX_NAME_LEN, "'Box_Red_%zu'", box_id);
+    o[0].target = box->name;
+    o[0].value = name;
+    o[1].target = box->pose;
+    o[1].value = pose;
+    o[2].target = box->visual.size;
+    o[2].value = size;
+    o[3].target = box->collision.size;
+    o[3].value = size;
 
-    // substitute name and position in document and append it
-    search_n_replace_attr(box_d.root, "model", "name", name);
-    search_n_replace_cont(box_d.root->children, "pose", pose);
-    sdf_element_append(&world->root->children, box_d.root);
+    sdf_writer_template(w, &box->document, box->document.root, o, 4);
 }
 
 /**
- * Generate a maze and print onto screen
- * [IN] struct maze*: maze will be stored here
+ * Write a box for each wall block of the maze
+ * [IN] struct sdf_writer*: writer of the world
+ * [IN] struct box_template*: box template
+ * [IN] int: 1 to write the boxes into the maze model
+ * [IN] struct maze*: maze to be converted
+ * [OUT] long: number of boxes written
+ **/
+long add_walls(struct sdf_writer* w, struct box_template* box, int single, struct maze* m) {
+    uint32_t    i, j;
+    long        n = 0;
+
+    // for each block of the maze, write a box into the 3D world
+    for (i = 0; i < m->height; i++) {
+        for (j = 0; j < m->width; j++)
+            if(get_block(m, i, j) == WALL) {
+                add_box(w, box, single, (size_t)i * m->width + j, i * BOX_DIM, j * BOX_DIM, 0,
+                        BOX_DIM, BOX_DIM, BOX_DIM);
+                n++;
+            }
+    }
+
+    return n;
+}
+
+/**
+ * Merge adjacent wall blocks of the maze and write a box for each rectangle
+ * [IN] struct sdf_writer*: writer of the world
+ * [IN] struct box_template*: box template
+ * [IN] int: 1 to write the boxes into the maze model
+ * [IN] struct maze*: maze to be converted
+ * [OUT] long: number of boxes written
+ **/
+long add_merged_walls(struct sdf_writer* w, struct box_template* box, int single, struct maze* m) {
+    struct wall_box*    boxes;  // rectangles covering the walls
+    struct wall_box*    b;      // current rectangle
+    long                i, n;
+
+    n = merge_walls(m, &boxes);
+
+    // exit in case of memory exhaust
+    if (n < 0)
+        print_and_die("Out of memory.", -1);
+
+    // the box is centered in the middle of the rectangle
+    for (i = 0; i < n; i++) {
+        b = boxes + i;
+        add_box(w, box, single, (size_t)b->x * m->width + b->y,
+                (b->x + (b->dx - 1) / 2.0) * BOX_DIM,
+                (b->y + (b->dy - 1) / 2.0) * BOX_DIM, 0,
+                b->dx * BOX_DIM, b->dy * BOX_DIM, BOX_DIM);
+    }
+
+    free(boxes);
+    return n;
+}
+
+/**
+ * Draw a row of the streaming generator and write its walls, merging
+ * adjacent walls of the row if requested
+ * [IN] void*: the row writer
+ * [IN] uint32_t: row position in the maze (x position)
+ * [IN] uint8_t*: blocks of the row
+ * [IN] uint32_t: number of blocks in the row
+ * [OUT] void
+ **/
+void add_row_walls(void* data, uint32_t x, uint8_t* row, uint32_t width) {
+    struct row_writer*  rw = data;
+    uint32_t            j, k;
+
+    // draw the row
+    if (rw->r != NULL)
+        render_row(rw->r, x, row, width);
+
+    // open the maze entrance
+    if (x < 2)
+        row[0] &= ~CELL_WALL;
+
+    // save the row
+    if (rw->f != NULL)
+        write_maze_row(rw->f, x, row, width);
+
+    // the walls go into the mesh
+    if (rw->mesh != NULL) {
+        mesh_row(rw->mesh, x, row, width);
+        return;
+    }
+
+    for (j = 0; j < width; j += k) {
+        if (!(row[j] & CELL_WALL)) {
+            k = 1;
+            continue;
+        }
+
+        // measure the run of walls starting from this block
+        for (k = 1; rw->merge && j + k < width && (row[j + k] & CELL_WALL); k++);
+
+        add_box(rw->w, rw->box, rw->single, (size_t)x * width + j, x * BOX_DIM,
+                (j + (k - 1) / 2.0) * BOX_DIM, 0, BOX_DIM, k * BOX_DIM, BOX_DIM);
+        rw->boxes++;
+    }
+}
+
+/**
+ * Read and check the maze size
  * [IN] char* w_str: must contain width in string version
  * [IN] char* h_str: must contain height in string version
+ * [IN] uint32_t*: width will be left here
+ * [IN] uint32_t*: height will be left here
  * [OUT] void
  **/
-void generate_maze(struct maze* m, char* w_str, char* h_str) {	
+void read_size(char* w_str, char* h_str, uint32_t* width, uint32_t* height) {
 	int ret;    // check for return values
-    int width;  // will contains width in numeric shape
-    int height; // will contains height in numeric shape
+    int w;      // will contains width in numeric shape
+    int h;      // will contains height in numeric shape
     
     // get width from str
-    ret = sscanf(w_str, "%d", &width);
+    ret = sscanf(w_str, "%d", &w);
 	if (ret < 1)
 		print_and_die("Invalid size 1 provided.", -1);
 
     // get height from str
-	ret = sscanf(h_str, "%d", &height);
+	ret = sscanf(h_str, "%d", &h);
 	if (ret < 1)
 		print_and_die("Invalid size 2 provided.", -1);
 
     // width and height must be odd
-	if (!(width % 2) || !(height % 2))
+	if (!(w % 2) || !(h % 2))
 		print_and_die("Only odd size are valid.", -1);
 	
     // width and height must be positive
-	if (width <= 0 || height <= 0)
+	if (w <= 0 || h <= 0)
 		print_and_die("Dimension must be positive.", -1);
 
-    // init the maze graph
-	ret = init_maze(m, width, height);
+    *width = w;
+    *height = h;
+}
 
-    // exit in case of memory exhaust
-	if (ret != 0)
-		print_and_die("Out of memory.", -1);
+/**
+ * Generate a maze, or load it from its file
+ * [IN] struct maze*: maze will be stored here
+ * [IN] struct settings*: how the maze is generated
+ * [IN] uint64_t: seed of the maze
+ * [OUT] void
+ **/
+void generate_maze(struct maze* m, struct settings* s, uint64_t seed) {
+    // the maze has been already generated
+    if (s->load != NULL) {
+        if (load_maze(s->load, m))
+            print_and_die("Out of memory.", -1);
+        return;
+    }
 
-    // create the maze
-    create_maze(m);
+    // init the maze graph
+	if (init_maze(m, s->width, s->height) != 0)
+		print_and_die("Out of memory.", -1);
 
-    // print onto screen
-    draw_maze(m);
+    // create the maze, the seed is enough to create it again
+    if (s->threads == 0)
+        create_maze(m, seed);
+    else if (create_maze_tiled(m, seed, TILE_NODES, s->threads))
+        print_and_die("Out of memory.", -1);
 }
-